@@ -0,0 +1,72 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+// Bounded blocking FIFO used between pipeline stages.
+// 队列满时 push 阻塞（背压），close 之后 pop 取完剩余元素返回 false。
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : cap(capacity ? capacity : 1) {}
+
+    // 返回 false 表示队列已关闭，元素未入队。
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (items.size() >= cap && !closed) {
+            auto start = std::chrono::steady_clock::now();
+            notFull.wait(lock, [&] { return items.size() < cap || closed; });
+            blockedNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+        if (closed) return false;
+        items.push_back(std::move(item));
+        ++pushes;
+        depthSum += items.size();
+        if (items.size() > peak) peak = items.size();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mtx);
+        notEmpty.wait(lock, [&] { return !items.empty() || closed; });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    size_t capacity() const { return cap; }
+    size_t size() const { std::lock_guard<std::mutex> lock(mtx); return items.size(); }
+    size_t maxDepth() const { std::lock_guard<std::mutex> lock(mtx); return peak; }
+    // 入队瞬间的平均深度，接近容量说明下游是瓶颈。
+    double averageDepth() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return pushes ? static_cast<double>(depthSum) / pushes : 0.0;
+    }
+    // 生产者因队列满而等待的累计时间。
+    double blockedSeconds() const { std::lock_guard<std::mutex> lock(mtx); return blockedNs / 1e9; }
+
+private:
+    const size_t cap;
+    mutable std::mutex mtx;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<T> items;
+    bool closed = false;
+    uint64_t pushes = 0;
+    uint64_t depthSum = 0;
+    uint64_t blockedNs = 0;
+    size_t peak = 0;
+};
@@ -0,0 +1,76 @@
+#include "ColorTransform.h"
+#include "Progress.h"
+#include <stdexcept>
+
+namespace {
+thread_local ColorTransform::Kind currentKind = ColorTransform::Kind::None;
+
+// 提升步骤里的 >>1 按有符号值计算，使色度在 0 附近时预测最准确。
+inline uint8_t half(uint8_t v) {
+    return static_cast<uint8_t>(static_cast<int8_t>(v) >> 1);
+}
+}
+
+ColorTransform::Scope::Scope(Kind kind) : previous(currentKind) {
+    currentKind = kind;
+}
+
+ColorTransform::Scope::~Scope() {
+    currentKind = previous;
+}
+
+ColorTransform::Kind ColorTransform::current() {
+    return currentKind;
+}
+
+bool ColorTransform::isKnown(uint8_t kind) {
+    return kind == static_cast<uint8_t>(Kind::None) || kind == static_cast<uint8_t>(Kind::YCoCgR);
+}
+
+void ColorTransform::forward(const cv::Mat &bgr, std::vector<std::vector<uint8_t>> &planes) {
+    if (bgr.type() != CV_8UC3) throw std::runtime_error("Colour transform requires an 8-bit 3-channel image");
+    size_t w = static_cast<size_t>(bgr.cols);
+    planes.assign(3, std::vector<uint8_t>(w * bgr.rows));
+    for (int y = 0; y < bgr.rows; ++y) {
+        if (y % 256 == 0) Progress::report(y, bgr.rows);
+        // 无分支的逐像素循环；目标指令集支持字节重排（SSSE3/AVX2/NEON）时编译器会向量化交错读取。
+        const uint8_t *src = bgr.ptr<uint8_t>(y);
+        uint8_t *py = planes[0].data() + y * w;
+        uint8_t *pco = planes[1].data() + y * w;
+        uint8_t *pcg = planes[2].data() + y * w;
+        for (size_t x = 0; x < w; ++x) {
+            uint8_t b = src[3 * x], g = src[3 * x + 1], r = src[3 * x + 2];
+            uint8_t co = static_cast<uint8_t>(r - b);
+            uint8_t t = static_cast<uint8_t>(b + half(co));
+            uint8_t cg = static_cast<uint8_t>(g - t);
+            py[x] = static_cast<uint8_t>(t + half(cg));
+            pco[x] = co;
+            pcg[x] = cg;
+        }
+    }
+}
+
+cv::Mat ColorTransform::inverse(const std::vector<std::vector<uint8_t>> &planes, int width, int height) {
+    size_t w = static_cast<size_t>(width);
+    if (planes.size() != 3 || planes[0].size() != w * height || planes[1].size() != w * height ||
+        planes[2].size() != w * height) {
+        throw std::runtime_error("Colour transform plane size mismatch");
+    }
+    cv::Mat bgr(height, width, CV_8UC3);
+    for (int y = 0; y < height; ++y) {
+        if (y % 256 == 0) Progress::report(y, height);
+        const uint8_t *py = planes[0].data() + y * w;
+        const uint8_t *pco = planes[1].data() + y * w;
+        const uint8_t *pcg = planes[2].data() + y * w;
+        uint8_t *dst = bgr.ptr<uint8_t>(y);
+        for (size_t x = 0; x < w; ++x) {
+            uint8_t t = static_cast<uint8_t>(py[x] - half(pcg[x]));
+            uint8_t g = static_cast<uint8_t>(pcg[x] + t);
+            uint8_t b = static_cast<uint8_t>(t - half(pco[x]));
+            dst[3 * x] = b;
+            dst[3 * x + 1] = g;
+            dst[3 * x + 2] = static_cast<uint8_t>(b + pco[x]);
+        }
+    }
+    return bgr;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Reversible integer colour transform for 3-channel lossless coding.
+// YCoCg-R 提升步骤在模 256 下进行，三个平面仍为 8 位且可精确还原；
+// 色度平面集中在 0 附近，熵明显低于原始 B/G/R 平面。
+namespace ColorTransform {
+enum class Kind : uint8_t { None = 0, YCoCgR = 1 };
+
+// RAII：在当前线程为无损编码器选择颜色变换，析构时恢复之前的设置。
+// 编码器把所用变换写入文件头，解码端无需设置。
+class Scope {
+public:
+    explicit Scope(Kind kind);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+private:
+    Kind previous;
+};
+
+Kind current();
+// 文件头中的变换字节是否有效。
+bool isKnown(uint8_t kind);
+
+// 交错 BGR 单次遍历直接写出 Y、Co、Cg 三个平面（替代 split）。
+void forward(const cv::Mat &bgr, std::vector<std::vector<uint8_t>> &planes);
+// 由 Y、Co、Cg 平面单次遍历写回交错 BGR。
+cv::Mat inverse(const std::vector<std::vector<uint8_t>> &planes, int width, int height);
+}
@@ -2,7 +2,10 @@
 #include "Huffman.h"
 #include "RLE.h"
 #include "LZW.h"
+#include "LZ77.h"
 #include "DCTCodec.h"
+#include "WaveletCodec.h"
+#include <ostream>
 #include <stdexcept>
 
 // 根据字符串名称解析枚举，便于在 CLI 与内部算法实现间解耦。
@@ -11,24 +14,77 @@ static Algorithm parseAlgo(const std::string &name) {
     if (name == "rle") return Algorithm::RLE;
     if (name == "lzw") return Algorithm::LZW;
     if (name == "dct") return Algorithm::DCT;
+    if (name == "wavelet") return Algorithm::Wavelet;
+    if (name == "lz77") return Algorithm::LZ77;
     throw std::runtime_error("Unknown algorithm: " + name);
 }
 
 void Compressor::compressImage(const std::string &algoName, const cv::Mat &img, const std::string &outputPath, int quality) {
+    std::vector<uint8_t> buffer;
+    compressImage(algoName, img, buffer, quality);
+    ImageIO::writeFile(outputPath, buffer);
+}
+
+void Compressor::compressImage(const std::string &algoName, const cv::Mat &img, std::vector<uint8_t> &out, int quality) {
     Algorithm algo = parseAlgo(algoName);
     // 通过统一的 switch 分发到具体编码器，方便后续扩展新算法。
     switch (algo) {
         case Algorithm::Huffman:
-            Huffman::compress(img, outputPath);
+            Huffman::compress(img, out);
             break;
         case Algorithm::RLE:
-            RLE::compress(img, outputPath);
+            RLE::compress(img, out);
             break;
         case Algorithm::LZW:
-            LZW::compress(img, outputPath);
+            LZW::compress(img, out);
             break;
         case Algorithm::DCT:
-            DCTCodec::compress(img, outputPath, quality);
+            DCTCodec::compress(img, out, quality);
+            break;
+        case Algorithm::Wavelet:
+            WaveletCodec::compress(img, out, quality);
             break;
+        case Algorithm::LZ77:
+            LZ77::compress(img, out);
+            break;
+    }
+}
+
+std::vector<uint8_t> Compressor::compressToBuffer(const std::string &algoName, const cv::Mat &img, int quality) {
+    std::vector<uint8_t> out;
+    compressImage(algoName, img, out, quality);
+    return out;
+}
+
+void Compressor::compressImage(const std::string &algoName, const cv::Mat &img, std::ostream &out, int quality) {
+    // 先编码到缓冲区再整体写出，算法分发只保留在缓冲区入口一处。
+    std::vector<uint8_t> buffer;
+    compressImage(algoName, img, buffer, quality);
+    out.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+}
+
+bool Compressor::isLossless(const std::string &algoName) {
+    switch (parseAlgo(algoName)) {
+        case Algorithm::Huffman:
+        case Algorithm::RLE:
+        case Algorithm::LZW:
+        case Algorithm::LZ77:
+            return true;
+        case Algorithm::DCT:
+        case Algorithm::Wavelet:
+            return false;
+    }
+    return false;
+}
+
+std::string Compressor::fileExtension(const std::string &algoName) {
+    switch (parseAlgo(algoName)) {
+        case Algorithm::Huffman: return ".huf";
+        case Algorithm::RLE: return ".rle";
+        case Algorithm::LZW: return ".lzw";
+        case Algorithm::DCT: return ".dct";
+        case Algorithm::Wavelet: return ".wlt";
+        case Algorithm::LZ77: return ".lz77";
     }
+    throw std::runtime_error("Unsupported algorithm");
 }
@@ -1,9 +1,21 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <iosfwd>
 #include <opencv2/opencv.hpp>
 
-enum class Algorithm { Huffman, RLE, LZW, DCT };
+enum class Algorithm { Huffman, RLE, LZW, DCT, Wavelet, LZ77 };
 
 namespace Compressor {
 void compressImage(const std::string &algoName, const cv::Mat &img, const std::string &outputPath, int quality = 75);
+void compressImage(const std::string &algoName, const cv::Mat &img, std::ostream &out, int quality = 75);
+// 编码到调用方提供的缓冲区（先清空再写入，保留已有容量以便复用）。
+void compressImage(const std::string &algoName, const cv::Mat &img, std::vector<uint8_t> &out, int quality = 75);
+std::vector<uint8_t> compressToBuffer(const std::string &algoName, const cv::Mat &img, int quality = 75);
+// 算法对应的默认文件扩展名（含点），批处理时用于生成输出文件名。
+std::string fileExtension(const std::string &algoName);
+// 逐通道无损编码字节平面的算法（huffman/rle/lzw/lz77），容器格式与颜色变换只接受这些算法。
+// wavelet 虽有无损模式，但由质量参数决定，不计入；未知算法名抛出异常。
+bool isLossless(const std::string &algoName);
 }
@@ -1,5 +1,12 @@
 #include "DCTCodec.h"
-#include <fstream>
+#include "Huffman.h"
+#include "JFIF.h"
+#include "MemProfile.h"
+#include "MemoryStream.h"
+#include "Metrics.h"
+#include "Progress.h"
+#include <istream>
+#include <ostream>
 #include <cmath>
 #include <stdexcept>
 #include <algorithm>
@@ -8,6 +15,17 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+const int DCTCodec::kZigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+};
+
 namespace {
 const int N = 8;
 // JPEG-like luminance base matrix
@@ -22,72 +40,288 @@ const int baseQ[8][8] = {
     {72,92,95,98,112,100,103,99}
 };
 
+// 文件头 quality 之后的第一个填充字节记录系数存储方式。
+const uint8_t kFormatRaw = 0;     // 每块 64 个 int16 原样存储
+const uint8_t kFormatEntropy = 1; // zigzag 游程符号 + 哈夫曼编码（旧版：每路流带 256 项 u64 频率表）
+const uint8_t kFormatEntropyBlocks = 2; // 同上，符号流改用分块哈夫曼（每块 128 字节规范码长表）
+const uint8_t kEndOfBlock = 63;
+// 第二个填充字节记录量化表：旧文件为 0（浮点缩放），新文件为 1（IJG 整数表，可直接写入 JFIF 的 DQT）。
+const uint8_t kQuantScaled = 0;
+const uint8_t kQuantInteger = 1;
+
 double alpha(int u) { return u == 0 ? std::sqrt(1.0 / N) : std::sqrt(2.0 / N); }
 
+// basis[x][u] = alpha(u) * cos((2x+1)uπ/16)，预先计算后按行列分离做两次一维变换。
+struct Basis {
+    double c[8][8];
+    Basis() {
+        for (int x = 0; x < N; ++x) {
+            for (int u = 0; u < N; ++u) {
+                c[x][u] = alpha(u) * std::cos(((2 * x + 1) * u * M_PI) / (2 * N));
+            }
+        }
+    }
+};
+
+const Basis &basis() {
+    static const Basis b;
+    return b;
+}
+
 void dct8x8(const double in[8][8], double out[8][8]) {
+    const auto &c = basis().c;
+    double tmp[8][8];
+    for (int u = 0; u < N; ++u) {
+        for (int y = 0; y < N; ++y) {
+            double sum = 0.0;
+            for (int x = 0; x < N; ++x) sum += c[x][u] * in[x][y];
+            tmp[u][y] = sum;
+        }
+    }
     for (int u = 0; u < N; ++u) {
         for (int v = 0; v < N; ++v) {
             double sum = 0.0;
-            for (int x = 0; x < N; ++x) {
-                for (int y = 0; y < N; ++y) {
-                    sum += in[x][y] *
-                        std::cos(((2 * x + 1) * u * M_PI) / (2 * N)) *
-                        std::cos(((2 * y + 1) * v * M_PI) / (2 * N));
-                }
-            }
-            out[u][v] = alpha(u) * alpha(v) * sum;
+            for (int y = 0; y < N; ++y) sum += c[y][v] * tmp[u][y];
+            out[u][v] = sum;
         }
     }
 }
 
 void idct8x8(const double in[8][8], double out[8][8]) {
+    const auto &c = basis().c;
+    double tmp[8][8];
+    for (int x = 0; x < N; ++x) {
+        for (int v = 0; v < N; ++v) {
+            double sum = 0.0;
+            for (int u = 0; u < N; ++u) sum += c[x][u] * in[u][v];
+            tmp[x][v] = sum;
+        }
+    }
     for (int x = 0; x < N; ++x) {
         for (int y = 0; y < N; ++y) {
             double sum = 0.0;
-            for (int u = 0; u < N; ++u) {
-                for (int v = 0; v < N; ++v) {
-                    sum += alpha(u) * alpha(v) * in[u][v] *
-                        std::cos(((2 * x + 1) * u * M_PI) / (2 * N)) *
-                        std::cos(((2 * y + 1) * v * M_PI) / (2 * N));
-                }
-            }
+            for (int v = 0; v < N; ++v) sum += c[y][v] * tmp[x][v];
             out[x][y] = sum;
         }
     }
 }
 
-void buildQuantMatrix(int quality, double q[8][8]) {
+// 与 IJG libjpeg 相同的整数缩放，结果限制在基线 JPEG 允许的 1-255。
+void buildQuantTable(int quality, uint8_t table[64]) {
+    int qf = std::max(1, std::min(quality, 100));
+    int percent = (qf < 50) ? 5000 / qf : 200 - 2 * qf;
+    for (int k = 0; k < 64; ++k) {
+        int q = (baseQ[k / 8][k % 8] * percent + 50) / 100;
+        table[k] = static_cast<uint8_t>(std::max(1, std::min(q, 255)));
+    }
+}
+
+void buildQuantMatrix(int quality, double q[8][8], bool legacyScaled = false) {
     int qf = std::max(1, std::min(quality, 100));
+    if (!legacyScaled) {
+        uint8_t table[64];
+        buildQuantTable(qf, table);
+        for (int k = 0; k < 64; ++k) q[k / 8][k % 8] = table[k];
+        return;
+    }
     double scale = (qf < 50) ? 50.0 / qf : (200.0 - 2 * qf) / 100.0;
     for (int i = 0; i < N; ++i) {
         for (int j = 0; j < N; ++j) {
-            q[i][j] = baseQ[i][j] * scale;
+            // 旧版步长保持原公式（q96-99 时小于 1）；仅 quality=100 时 scale 为 0，取 1 避免除零。
+            q[i][j] = scale > 0.0 ? baseQ[i][j] * scale : 1.0;
         }
     }
 }
-}
 
-void DCTCodec::compress(const cv::Mat &img, const std::string &outputPath, int quality) {
+cv::Mat toGray(const cv::Mat &img) {
     cv::Mat gray;
     if (img.channels() == 3) {
         cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
     } else {
-        gray = img.clone();
+        gray = img;
     }
     if (gray.channels() != 1) throw std::runtime_error("DCT only supports 1 channel");
+    return gray;
+}
+
+void writeHeader(std::ostream &ofs, const DCTCodec::Coefficients &coeffs, int quality, uint8_t format) {
+    ofs.write("DCT ", 4);
+    ofs.write(reinterpret_cast<const char*>(&coeffs.width), sizeof(uint32_t));
+    ofs.write(reinterpret_cast<const char*>(&coeffs.height), sizeof(uint32_t));
+    uint8_t channels = 1;
+    ofs.put(static_cast<char>(channels));
+    ofs.put(0); ofs.put(0); ofs.put(0);
+    uint8_t qByte = static_cast<uint8_t>(std::max(1, std::min(quality, 100)));
+    ofs.put(static_cast<char>(qByte));
+    ofs.put(static_cast<char>(format)); ofs.put(static_cast<char>(kQuantInteger)); ofs.put(0); // format + quant table + pad
+    ofs.write(reinterpret_cast<const char*>(&coeffs.paddedW), sizeof(uint32_t));
+    ofs.write(reinterpret_cast<const char*>(&coeffs.paddedH), sizeof(uint32_t));
+}
+
+const size_t kHeaderSize = 4 + 4 + 4 + 4 + 4 + 4 + 4;
+
+// 有符号系数经 zigzag 映射为无符号数后按 7 位一组变长存储。
+void appendValue(std::vector<uint8_t> &out, int value) {
+    uint32_t u = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    while (u >= 0x80) {
+        out.push_back(static_cast<uint8_t>(u | 0x80));
+        u >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(u));
+}
+
+int readValue(const std::vector<uint8_t> &in, size_t &pos) {
+    uint32_t u = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (pos >= in.size() || shift > 21) throw std::runtime_error("Corrupted DCT coefficient stream");
+        uint8_t b = in[pos++];
+        u |= static_cast<uint32_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    return static_cast<int>(u >> 1) ^ -static_cast<int>(u & 1);
+}
+
+// 两路符号流：tokens 为 AC 零游程长度（kEndOfBlock 表示块结束），
+// values 为 DC 差分与非零 AC 值。分开编码让两者各自拥有哈夫曼表。
+void buildSymbolStreams(const std::vector<DCTCodec::QuantBlock> &blocks, std::vector<uint8_t> &tokens, std::vector<uint8_t> &values) {
+    tokens.clear();
+    values.clear();
+    int prevDC = 0;
+    for (const auto &qb : blocks) {
+        appendValue(values, qb.coeffs[0] - prevDC);
+        prevDC = qb.coeffs[0];
+        int run = 0;
+        for (int k = 1; k < 64; ++k) {
+            int v = qb.coeffs[DCTCodec::kZigzag[k]];
+            if (v == 0) {
+                ++run;
+                continue;
+            }
+            tokens.push_back(static_cast<uint8_t>(run));
+            appendValue(values, v);
+            run = 0;
+        }
+        tokens.push_back(kEndOfBlock);
+    }
+}
+
+std::vector<DCTCodec::QuantBlock> parseSymbolStreams(const std::vector<uint8_t> &tokens, const std::vector<uint8_t> &values, size_t blockCount) {
+    std::vector<DCTCodec::QuantBlock> blocks(blockCount);
+    size_t tpos = 0, vpos = 0;
+    int prevDC = 0;
+    for (auto &qb : blocks) {
+        std::fill(std::begin(qb.coeffs), std::end(qb.coeffs), 0);
+        prevDC += readValue(values, vpos);
+        qb.coeffs[0] = static_cast<int16_t>(prevDC);
+        int k = 1;
+        while (true) {
+            if (tpos >= tokens.size()) throw std::runtime_error("Corrupted DCT token stream");
+            uint8_t t = tokens[tpos++];
+            if (t == kEndOfBlock) break;
+            k += t;
+            if (k >= 64) throw std::runtime_error("Corrupted DCT token stream");
+            qb.coeffs[DCTCodec::kZigzag[k++]] = static_cast<int16_t>(readValue(values, vpos));
+        }
+    }
+    return blocks;
+}
+
+// 每路符号流：u32 原始长度 + Huffman::encodeBlocks 的分块布局（规范码长表，每块 128 字节）。
+// 旧版频率表布局每路固定约 2KB，使很小的 --target-bytes 无法达到，只保留读取。
+void writeStream(std::ostream &ofs, const std::vector<uint8_t> &symbols) {
+    uint32_t rawSize = static_cast<uint32_t>(symbols.size());
+    ofs.write(reinterpret_cast<const char*>(&rawSize), sizeof(uint32_t));
+    Huffman::encodeBlocks(symbols, ofs);
+}
+
+std::vector<uint8_t> readStream(std::istream &ifs, uint8_t format) {
+    uint32_t rawSize = 0;
+    ifs.read(reinterpret_cast<char*>(&rawSize), sizeof(uint32_t));
+    if (!ifs) throw std::runtime_error("Truncated DCT stream");
+    if (format == kFormatEntropyBlocks) return Huffman::decodeBlocks(ifs, rawSize);
+    std::array<uint64_t,256> freq;
+    ifs.read(reinterpret_cast<char*>(freq.data()), sizeof(uint64_t) * 256);
+    uint64_t validBits = 0; uint32_t sz = 0;
+    ifs.read(reinterpret_cast<char*>(&validBits), sizeof(uint64_t));
+    ifs.read(reinterpret_cast<char*>(&sz), sizeof(uint32_t));
+    if (!ifs) throw std::runtime_error("Truncated DCT stream");
+    std::vector<uint8_t> encoded(sz);
+    ifs.read(reinterpret_cast<char*>(encoded.data()), sz);
+    auto symbols = Huffman::decompressChannel(encoded, validBits, freq);
+    if (symbols.size() != rawSize) throw std::runtime_error("Corrupted DCT stream");
+    return symbols;
+}
+
+uint64_t streamSize(const std::vector<uint8_t> &symbols) {
+    return sizeof(uint32_t) + Huffman::encodedBlocksSize(symbols);
+}
+
+// .dct 文件解析结果：头部字段与量化后的块，供解码与 JFIF 转封装共用。
+struct Parsed {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t paddedW = 0;
+    uint32_t paddedH = 0;
+    int quality = 50;
+    bool legacyScaled = false;
+    std::vector<DCTCodec::QuantBlock> blocks;
+};
+
+Parsed parseFile(std::istream &ifs) {
+    char magic[4]; ifs.read(magic,4);
+    if (std::string(magic,4) != "DCT ") throw std::runtime_error("Invalid magic for DCT");
+    Parsed f;
+    uint8_t channels = 0;
+    ifs.read(reinterpret_cast<char*>(&f.width), sizeof(uint32_t));
+    ifs.read(reinterpret_cast<char*>(&f.height), sizeof(uint32_t));
+    ifs.read(reinterpret_cast<char*>(&channels),1);
+    char pad[3]; ifs.read(pad,3);
+    if (channels != 1) throw std::runtime_error("DCT expects 1 channel");
+    uint8_t qualityByte = 50; char pad2[3];
+    ifs.read(reinterpret_cast<char*>(&qualityByte),1);
+    ifs.read(pad2,3);
+    uint8_t format = static_cast<uint8_t>(pad2[0]);
+    uint8_t quant = static_cast<uint8_t>(pad2[1]);
+    if (quant != kQuantScaled && quant != kQuantInteger) throw std::runtime_error("Unsupported DCT quantization table");
+    f.quality = qualityByte;
+    f.legacyScaled = quant == kQuantScaled;
+    ifs.read(reinterpret_cast<char*>(&f.paddedW), sizeof(uint32_t));
+    ifs.read(reinterpret_cast<char*>(&f.paddedH), sizeof(uint32_t));
+
+    size_t blockCount = static_cast<size_t>(f.paddedW / 8) * (f.paddedH / 8);
+    if (format == kFormatEntropy || format == kFormatEntropyBlocks) {
+        auto tokens = readStream(ifs, format);
+        auto values = readStream(ifs, format);
+        f.blocks = parseSymbolStreams(tokens, values, blockCount);
+    } else if (format == kFormatRaw) {
+        f.blocks.resize(blockCount);
+        for (auto &qb : f.blocks) {
+            ifs.read(reinterpret_cast<char*>(qb.coeffs), sizeof(int16_t) * 64);
+        }
+    } else {
+        throw std::runtime_error("Unsupported DCT coefficient format");
+    }
+    return f;
+}
+}
 
-    uint32_t width = static_cast<uint32_t>(gray.cols);
-    uint32_t height = static_cast<uint32_t>(gray.rows);
-    int paddedW = (width + 7) / 8 * 8;
-    int paddedH = (height + 7) / 8 * 8;
+DCTCodec::Coefficients DCTCodec::forwardTransform(const cv::Mat &img) {
+    MemProfile::Scope memScope("dct:transform");
+    cv::Mat gray = toGray(img);
+    Coefficients coeffs;
+    coeffs.width = static_cast<uint32_t>(gray.cols);
+    coeffs.height = static_cast<uint32_t>(gray.rows);
+    int paddedW = (gray.cols + 7) / 8 * 8;
+    int paddedH = (gray.rows + 7) / 8 * 8;
+    coeffs.paddedW = static_cast<uint32_t>(paddedW);
+    coeffs.paddedH = static_cast<uint32_t>(paddedH);
     cv::Mat padded;
     cv::copyMakeBorder(gray, padded, 0, paddedH - gray.rows, 0, paddedW - gray.cols, cv::BORDER_REPLICATE);
 
-    double qmat[8][8];
-    buildQuantMatrix(quality, qmat);
-
-    std::vector<QuantBlock> blocks;
+    coeffs.values.resize(static_cast<size_t>(paddedW / 8) * (paddedH / 8) * 64);
+    float *dst = coeffs.values.data();
     for (int y = 0; y < paddedH; y += 8) {
+        Progress::report(y, paddedH);
         for (int x = 0; x < paddedW; x += 8) {
             double block[8][8];
             for (int i = 0; i < 8; ++i) {
@@ -97,64 +331,44 @@ void DCTCodec::compress(const cv::Mat &img, const std::string &outputPath, int q
             }
             double freq[8][8];
             dct8x8(block, freq);
-            QuantBlock qb{};
             for (int i = 0; i < 8; ++i) {
                 for (int j = 0; j < 8; ++j) {
-                    double q = qmat[i][j];
-                    qb.coeffs[i*8 + j] = static_cast<int16_t>(std::round(freq[i][j] / q));
+                    *dst++ = static_cast<float>(freq[i][j]);
                 }
             }
-            blocks.push_back(qb);
         }
     }
+    return coeffs;
+}
 
-    std::ofstream ofs(outputPath, std::ios::binary);
-    if (!ofs) throw std::runtime_error("Cannot open output file");
-    ofs.write("DCT ", 4);
-    ofs.write(reinterpret_cast<const char*>(&width), sizeof(uint32_t));
-    ofs.write(reinterpret_cast<const char*>(&height), sizeof(uint32_t));
-    uint8_t channels = 1;
-    ofs.put(static_cast<char>(channels));
-    ofs.put(0); ofs.put(0); ofs.put(0);
-    uint8_t qByte = static_cast<uint8_t>(std::max(1, std::min(quality, 100)));
-    ofs.put(static_cast<char>(qByte));
-    ofs.put(0); ofs.put(0); ofs.put(0); // pad
-    uint32_t padW32 = static_cast<uint32_t>(paddedW);
-    uint32_t padH32 = static_cast<uint32_t>(paddedH);
-    ofs.write(reinterpret_cast<const char*>(&padW32), sizeof(uint32_t));
-    ofs.write(reinterpret_cast<const char*>(&padH32), sizeof(uint32_t));
-    for (const auto &qb : blocks) {
-        ofs.write(reinterpret_cast<const char*>(qb.coeffs), sizeof(int16_t) * 64);
+std::vector<DCTCodec::QuantBlock> DCTCodec::quantize(const Coefficients &coeffs, int quality) {
+    MemProfile::Scope memScope("dct:quantize");
+    double qmat[8][8];
+    buildQuantMatrix(quality, qmat);
+    double inv[64];
+    for (int k = 0; k < 64; ++k) inv[k] = 1.0 / qmat[k / 8][k % 8];
+    std::vector<QuantBlock> blocks(coeffs.values.size() / 64);
+    const float *src = coeffs.values.data();
+    for (auto &qb : blocks) {
+        for (int k = 0; k < 64; ++k) {
+            qb.coeffs[k] = static_cast<int16_t>(std::round(src[k] * inv[k]));
+        }
+        src += 64;
     }
+    return blocks;
 }
 
-cv::Mat DCTCodec::decompress(const std::string &inputPath) {
-    std::ifstream ifs(inputPath, std::ios::binary);
-    if (!ifs) throw std::runtime_error("Cannot open input file");
-    char magic[4]; ifs.read(magic,4);
-    if (std::string(magic,4) != "DCT ") throw std::runtime_error("Invalid magic for DCT");
-    uint32_t width = 0, height = 0; uint8_t channels = 0;
-    ifs.read(reinterpret_cast<char*>(&width), sizeof(uint32_t));
-    ifs.read(reinterpret_cast<char*>(&height), sizeof(uint32_t));
-    ifs.read(reinterpret_cast<char*>(&channels),1);
-    char pad[3]; ifs.read(pad,3);
-    if (channels != 1) throw std::runtime_error("DCT expects 1 channel");
-    uint8_t qualityByte = 50; char pad2[3];
-    ifs.read(reinterpret_cast<char*>(&qualityByte),1);
-    ifs.read(pad2,3);
-    uint32_t paddedW = 0, paddedH = 0;
-    ifs.read(reinterpret_cast<char*>(&paddedW), sizeof(uint32_t));
-    ifs.read(reinterpret_cast<char*>(&paddedH), sizeof(uint32_t));
+cv::Mat DCTCodec::reconstruct(const std::vector<QuantBlock> &blocks, int quality, uint32_t width, uint32_t height, uint32_t paddedW, uint32_t paddedH, bool legacyScaled) {
     double qmat[8][8];
-    buildQuantMatrix(qualityByte, qmat);
-
+    buildQuantMatrix(quality, qmat, legacyScaled);
     int blocksX = paddedW / 8;
     int blocksY = paddedH / 8;
+    if (blocks.size() < static_cast<size_t>(blocksX) * blocksY) throw std::runtime_error("Not enough DCT blocks");
     cv::Mat padded(paddedH, paddedW, CV_8UC1);
     for (int by = 0; by < blocksY; ++by) {
+        Progress::report(by, blocksY);
         for (int bx = 0; bx < blocksX; ++bx) {
-            QuantBlock qb{};
-            ifs.read(reinterpret_cast<char*>(qb.coeffs), sizeof(int16_t) * 64);
+            const QuantBlock &qb = blocks[static_cast<size_t>(by) * blocksX + bx];
             double freq[8][8];
             for (int i = 0; i < 8; ++i) {
                 for (int j = 0; j < 8; ++j) {
@@ -175,3 +389,154 @@ cv::Mat DCTCodec::decompress(const std::string &inputPath) {
     cv::Mat cropped = padded(cv::Rect(0,0,width,height)).clone();
     return cropped;
 }
+
+uint64_t DCTCodec::estimateEncodedSize(const std::vector<QuantBlock> &blocks) {
+    std::vector<uint8_t> tokens, values;
+    buildSymbolStreams(blocks, tokens, values);
+    return kHeaderSize + streamSize(tokens) + streamSize(values);
+}
+
+void DCTCodec::compress(const cv::Mat &img, const std::string &outputPath, int quality) {
+    std::vector<uint8_t> buffer;
+    compress(img, buffer, quality);
+    ImageIO::writeFile(outputPath, buffer);
+}
+
+void DCTCodec::compress(const cv::Mat &img, std::vector<uint8_t> &out, int quality) {
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    compress(img, os, quality);
+}
+
+void DCTCodec::compress(const cv::Mat &img, std::ostream &ofs, int quality) {
+    MemProfile::Scope memScope("dct");
+    Coefficients coeffs = forwardTransform(img);
+    std::vector<QuantBlock> blocks = quantize(coeffs, quality);
+    writeHeader(ofs, coeffs, quality, kFormatRaw);
+    for (const auto &qb : blocks) {
+        ofs.write(reinterpret_cast<const char*>(qb.coeffs), sizeof(int16_t) * 64);
+    }
+}
+
+void DCTCodec::writeEntropyCoded(const Coefficients &coeffs, const std::vector<QuantBlock> &blocks, int quality, std::ostream &ofs) {
+    std::vector<uint8_t> tokens, values;
+    buildSymbolStreams(blocks, tokens, values);
+    writeHeader(ofs, coeffs, quality, kFormatEntropyBlocks);
+    writeStream(ofs, tokens);
+    writeStream(ofs, values);
+}
+
+DCTCodec::TargetResult DCTCodec::compressToTarget(const cv::Mat &img, std::vector<uint8_t> &out, const Target &target) {
+    MemProfile::Scope memScope("dct");
+    cv::Mat gray = toGray(img);
+    Coefficients coeffs;
+    {
+        Progress::Section section(0, 2);
+        coeffs = forwardTransform(gray);
+    }
+    Progress::Section searchSection(1, 2);
+
+    // 每次评估只需重新量化缓存的系数，再估算码长或反变换计算 PSNR。
+    TargetResult result;
+    auto evaluate = [&](int q, std::vector<QuantBlock> &blocks, uint64_t &bytes, double &psnr) {
+        Progress::report(static_cast<uint64_t>(result.evaluations), 8);
+        blocks = quantize(coeffs, q);
+        bytes = estimateEncodedSize(blocks);
+        psnr = 0.0;
+        if (target.kind == Target::Kind::PSNR) {
+            cv::Mat rec = reconstruct(blocks, q, coeffs.width, coeffs.height, coeffs.paddedW, coeffs.paddedH);
+            psnr = Metrics::psnr(gray, rec);
+        }
+        ++result.evaluations;
+    };
+    auto satisfies = [&](uint64_t bytes, double psnr) {
+        return target.kind == Target::Kind::Bytes ? bytes <= target.value : psnr >= target.value;
+    };
+
+    // 码长与 PSNR 随 quality 单调（近似）递增：
+    // 字节目标找满足条件的最高 quality，PSNR 目标找满足条件的最低 quality。
+    int lo = 1, hi = 100;
+    int best = target.kind == Target::Kind::Bytes ? 1 : 100;
+    result.met = false;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        std::vector<QuantBlock> blocks;
+        uint64_t bytes; double psnr;
+        evaluate(mid, blocks, bytes, psnr);
+        if (satisfies(bytes, psnr)) {
+            best = mid;
+            result.met = true;
+            if (target.kind == Target::Kind::Bytes) lo = mid + 1; else hi = mid - 1;
+        } else {
+            if (target.kind == Target::Kind::Bytes) hi = mid - 1; else lo = mid + 1;
+        }
+    }
+
+    std::vector<QuantBlock> blocks = quantize(coeffs, best);
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    writeEntropyCoded(coeffs, blocks, best, os);
+    os.flush();
+
+    cv::Mat rec = reconstruct(blocks, best, coeffs.width, coeffs.height, coeffs.paddedW, coeffs.paddedH);
+    result.quality = best;
+    result.bytes = out.size();
+    result.psnr = Metrics::psnr(gray, rec);
+    result.ssim = Metrics::ssim(gray, rec);
+    return result;
+}
+
+cv::Mat DCTCodec::decompress(const std::string &inputPath) {
+    std::vector<uint8_t> buffer = ImageIO::readFile(inputPath);
+    return decompress(buffer.data(), buffer.size());
+}
+
+cv::Mat DCTCodec::decompress(const uint8_t *data, size_t size) {
+    SpanStreamBuf buf(data, size);
+    std::istream is(&buf);
+    return decompress(is);
+}
+
+cv::Mat DCTCodec::decompress(std::istream &ifs) {
+    MemProfile::Scope memScope("dct");
+    Parsed f = parseFile(ifs);
+    return reconstruct(f.blocks, f.quality, f.width, f.height, f.paddedW, f.paddedH, f.legacyScaled);
+}
+
+void DCTCodec::exportJFIF(const cv::Mat &img, std::vector<uint8_t> &out, int quality) {
+    MemProfile::Scope memScope("dct");
+    Coefficients coeffs = forwardTransform(img);
+    std::vector<QuantBlock> blocks = quantize(coeffs, quality);
+    uint8_t table[64];
+    buildQuantTable(quality, table);
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    JFIF::writeBaseline(os, coeffs.width, coeffs.height, table, blocks);
+}
+
+void DCTCodec::transcodeToJFIF(const uint8_t *data, size_t size, std::vector<uint8_t> &out) {
+    MemProfile::Scope memScope("dct");
+    SpanStreamBuf inBuf(data, size);
+    std::istream is(&inBuf);
+    Parsed f = parseFile(is);
+    uint8_t table[64];
+    buildQuantTable(f.quality, table);
+    if (f.legacyScaled) {
+        // 旧文件的量化步长不是整数：在系数域换算到整数表，省去反变换与正变换。
+        // 换算使用未截断的旧步长；q96-99 时旧步长小于 1，而 JPEG 步长至少为 1，这部分精度无法保留。
+        double legacy[8][8];
+        buildQuantMatrix(f.quality, legacy, true);
+        double ratio[64];
+        for (int k = 0; k < 64; ++k) ratio[k] = legacy[k / 8][k % 8] / table[k];
+        for (auto &qb : f.blocks) {
+            for (int k = 0; k < 64; ++k) qb.coeffs[k] = static_cast<int16_t>(std::round(qb.coeffs[k] * ratio[k]));
+        }
+    }
+    out.clear();
+    VectorStreamBuf outBuf(out);
+    std::ostream os(&outBuf);
+    JFIF::writeBaseline(os, f.width, f.height, table, f.blocks);
+}
@@ -2,6 +2,7 @@
 #include <vector>
 #include <cstdint>
 #include <string>
+#include <iosfwd>
 #include "ImageData.h"
 
 namespace DCTCodec {
@@ -9,6 +10,55 @@ struct QuantBlock { // store 64 coefficients
     int16_t coeffs[64];
 };
 
+// zigzag 扫描序号 -> 块内自然顺序下标（行优先），.dct 熵编码与 JFIF 导出共用。
+extern const int kZigzag[64];
+
+// Unquantized forward-DCT output, cached so quality can be re-chosen cheaply.
+// 每个 8x8 块 64 个系数按块行优先连续存放。
+struct Coefficients {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t paddedW = 0;
+    uint32_t paddedH = 0;
+    std::vector<float> values;
+};
+
+struct Target {
+    enum class Kind { Bytes, PSNR };
+    Kind kind = Kind::Bytes;
+    double value = 0.0; // 字节数上限或 PSNR 下限(dB)
+};
+
+struct TargetResult {
+    int quality = 0;
+    uint64_t bytes = 0;
+    double psnr = 0.0;
+    double ssim = 0.0;
+    int evaluations = 0;
+    bool met = false; // quality 1..100 范围内无法满足时为 false，此时取最接近的端点
+};
+
 void compress(const cv::Mat &img, const std::string &outputPath, int quality);
+void compress(const cv::Mat &img, std::ostream &out, int quality);
+void compress(const cv::Mat &img, std::vector<uint8_t> &out, int quality);
 cv::Mat decompress(const std::string &inputPath);
+cv::Mat decompress(std::istream &in);
+cv::Mat decompress(const uint8_t *data, size_t size);
+
+Coefficients forwardTransform(const cv::Mat &img);
+std::vector<QuantBlock> quantize(const Coefficients &coeffs, int quality);
+// legacyScaled 为 true 时使用旧版浮点缩放量化矩阵（量化表字节为 0 的旧文件）。
+cv::Mat reconstruct(const std::vector<QuantBlock> &blocks, int quality, uint32_t width, uint32_t height, uint32_t paddedW, uint32_t paddedH,
+                    bool legacyScaled = false);
+// 熵编码格式下的精确文件大小（由频率表计算，无需实际编码）。
+uint64_t estimateEncodedSize(const std::vector<QuantBlock> &blocks);
+void writeEntropyCoded(const Coefficients &coeffs, const std::vector<QuantBlock> &blocks, int quality, std::ostream &out);
+// 前向 DCT 只做一次，随后二分搜索 quality，写出满足目标的熵编码文件。
+TargetResult compressToTarget(const cv::Mat &img, std::vector<uint8_t> &out, const Target &target);
+
+// Baseline JFIF export (greyscale, standard Huffman tables), readable by any JPEG decoder.
+// 量化与 compress 相同，输出可直接作为 .jpg 提供。
+void exportJFIF(const cv::Mat &img, std::vector<uint8_t> &out, int quality);
+// 把 .dct 文件的量化系数直接重新封装为 JFIF，不做反变换；旧版量化表的文件在系数域换算。
+void transcodeToJFIF(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
 }
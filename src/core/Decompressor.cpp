@@ -3,7 +3,14 @@
 #include "Huffman.h"
 #include "RLE.h"
 #include "LZW.h"
+#include "LZ77.h"
 #include "DCTCodec.h"
+#include "Dedup.h"
+#include "WaveletCodec.h"
+#include "Palette.h"
+#include "Pyramid.h"
+#include <iterator>
+#include <istream>
 #include <stdexcept>
 
 // 解析算法名称，与压缩侧保持一致，确保解压时使用正确的编解码器。
@@ -12,21 +19,43 @@ static Algorithm parseAlgo(const std::string &name) {
     if (name == "rle") return Algorithm::RLE;
     if (name == "lzw") return Algorithm::LZW;
     if (name == "dct") return Algorithm::DCT;
+    if (name == "wavelet") return Algorithm::Wavelet;
+    if (name == "lz77") return Algorithm::LZ77;
     throw std::runtime_error("Unknown algorithm: " + name);
 }
 
 cv::Mat Decompressor::decompressImage(const std::string &algoName, const std::string &inputPath) {
+    parseAlgo(algoName);
+    std::vector<uint8_t> buffer = ImageIO::readFile(inputPath);
+    return decompressImage(algoName, buffer.data(), buffer.size());
+}
+
+cv::Mat Decompressor::decompressImage(const std::string &algoName, const uint8_t *data, size_t size) {
     Algorithm algo = parseAlgo(algoName);
-    // 根据枚举调用对应解码逻辑，保持与压缩入口的对称性。
+    // 容器格式按魔数识别，内部各层仍由 algoName 指定的编解码器解码。
+    if (Pyramid::isPyramid(data, size)) return Pyramid::decompress(algoName, data, size);
+    if (Palette::isPalette(data, size)) return Palette::decompress(algoName, data, size);
+    if (Dedup::isDedup(data, size)) return Dedup::decompress(algoName, data, size);
     switch (algo) {
         case Algorithm::Huffman:
-            return Huffman::decompress(inputPath);
+            return Huffman::decompress(data, size);
         case Algorithm::RLE:
-            return RLE::decompress(inputPath);
+            return RLE::decompress(data, size);
         case Algorithm::LZW:
-            return LZW::decompress(inputPath);
+            return LZW::decompress(data, size);
         case Algorithm::DCT:
-            return DCTCodec::decompress(inputPath);
+            return DCTCodec::decompress(data, size);
+        case Algorithm::Wavelet:
+            return WaveletCodec::decompress(data, size);
+        case Algorithm::LZ77:
+            return LZ77::decompress(data, size);
     }
     throw std::runtime_error("Unsupported algorithm");
 }
+
+cv::Mat Decompressor::decompressImage(const std::string &algoName, std::istream &in) {
+    parseAlgo(algoName);
+    // 读入流中剩余的全部字节后走缓冲区入口，容器格式的魔数识别只有一处。
+    std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return decompressImage(algoName, buffer.data(), buffer.size());
+}
@@ -1,7 +1,12 @@
 #pragma once
 #include <string>
+#include <cstdint>
+#include <iosfwd>
 #include <opencv2/opencv.hpp>
 
 namespace Decompressor {
 cv::Mat decompressImage(const std::string &algoName, const std::string &inputPath);
+// 从 in 读取剩余的全部字节，与缓冲区入口一样识别金字塔/调色板/去重容器。
+cv::Mat decompressImage(const std::string &algoName, std::istream &in);
+cv::Mat decompressImage(const std::string &algoName, const uint8_t *data, size_t size);
 }
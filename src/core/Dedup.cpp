@@ -0,0 +1,397 @@
+#include "Dedup.h"
+#include "Compressor.h"
+#include "Decompressor.h"
+#include "ImageData.h"
+#include "MemProfile.h"
+#include "MemoryStream.h"
+#include "Progress.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+
+namespace {
+void checkLossless(const std::string &algoName) {
+    if (!Compressor::isLossless(algoName)) {
+        throw std::runtime_error("Tile dedup requires a lossless codec (huffman, rle, lzw or lz77)");
+    }
+}
+
+void checkTileSize(size_t tileSize) {
+    if (tileSize < 8 || tileSize > 1024 || tileSize % 8 != 0) {
+        throw std::runtime_error("Tile size must be a multiple of 8 between 8 and 1024");
+    }
+}
+
+void appendVarint(std::vector<uint8_t> &out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+uint64_t readVarint(const std::vector<uint8_t> &in, size_t &pos) {
+    uint64_t v = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (pos >= in.size() || shift > 56) throw std::runtime_error("Corrupted dedup tile references");
+        uint8_t b = in[pos++];
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+// 图集：块按行排成近似正方形的网格，整体作为一张图像交给编解码器。
+cv::Mat buildAtlas(const std::vector<const std::vector<uint8_t>*> &tiles, size_t tile, int cn) {
+    size_t cols = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(tiles.size()))));
+    size_t rows = (tiles.size() + cols - 1) / cols;
+    cv::Mat atlas = cv::Mat::zeros(static_cast<int>(rows * tile), static_cast<int>(cols * tile), CV_MAKETYPE(CV_8U, cn));
+    size_t rowBytes = tile * cn;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        size_t x = (i % cols) * tile, y = (i / cols) * tile;
+        for (size_t r = 0; r < tile; ++r) {
+            std::memcpy(atlas.ptr<uint8_t>(static_cast<int>(y + r)) + x * cn, tiles[i]->data() + r * rowBytes, rowBytes);
+        }
+    }
+    return atlas;
+}
+
+std::vector<std::vector<uint8_t>> splitAtlas(const cv::Mat &atlas, size_t count, size_t tile, int cn) {
+    size_t cols = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    size_t rows = count ? (count + cols - 1) / cols : 0;
+    if (atlas.channels() != cn || static_cast<size_t>(atlas.cols) != cols * tile || static_cast<size_t>(atlas.rows) != rows * tile) {
+        throw std::runtime_error("Dedup tile atlas size mismatch");
+    }
+    size_t rowBytes = tile * cn;
+    std::vector<std::vector<uint8_t>> tiles(count, std::vector<uint8_t>(tile * rowBytes));
+    for (size_t i = 0; i < count; ++i) {
+        size_t x = (i % cols) * tile, y = (i / cols) * tile;
+        for (size_t r = 0; r < tile; ++r) {
+            std::memcpy(tiles[i].data() + r * rowBytes, atlas.ptr<uint8_t>(static_cast<int>(y + r)) + x * cn, rowBytes);
+        }
+    }
+    return tiles;
+}
+
+void writeAtlas(std::ostream &os, const std::string &algoName, const std::vector<const std::vector<uint8_t>*> &tiles,
+                size_t tile, int cn) {
+    std::vector<uint8_t> encoded;
+    if (!tiles.empty()) Compressor::compressImage(algoName, buildAtlas(tiles, tile, cn), encoded);
+    uint64_t size = encoded.size();
+    os.write(reinterpret_cast<const char*>(&size), sizeof(uint64_t));
+    os.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+}
+
+std::vector<std::vector<uint8_t>> readAtlas(const std::string &algoName, const uint8_t *data, size_t size, size_t &offset,
+                                            size_t count, size_t tile, int cn) {
+    uint64_t atlasSize = 0;
+    if (size - offset < sizeof(uint64_t)) throw std::runtime_error("Truncated dedup atlas");
+    std::memcpy(&atlasSize, data + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    if (size - offset < atlasSize) throw std::runtime_error("Truncated dedup atlas");
+    if (count == 0) return {};
+    cv::Mat atlas = Decompressor::decompressImage(algoName, data + offset, static_cast<size_t>(atlasSize));
+    offset += static_cast<size_t>(atlasSize);
+    return splitAtlas(atlas, count, tile, cn);
+}
+
+uint64_t newStoreId() {
+    std::random_device rd;
+    uint64_t id = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    id ^= static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    return id ? id : 1; // 0 表示“未使用块库”
+}
+}
+
+uint64_t Dedup::hashTile(const uint8_t *data, size_t size) {
+    // 每次处理 8 字节的乘法-移位混合；碰撞由调用方逐字节比较兜底。
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, data + i, sizeof(w));
+        h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    if (i < size) {
+        uint64_t w = 0;
+        std::memcpy(&w, data + i, size - i);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+    }
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+Dedup::Store::Store(size_t tileSize, size_t budget) : tile(tileSize), candidateBudget(budget), storeId(newStoreId()) {
+    checkTileSize(tileSize);
+}
+
+bool Dedup::Store::accepts(int cn) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (channels == 0) channels = cn;
+    return channels == cn;
+}
+
+int64_t Dedup::Store::match(uint64_t hash, const uint8_t *pixels, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto range = index.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const auto &t = tiles[it->second];
+        if (t.size() == size && std::memcmp(t.data(), pixels, size) == 0) return static_cast<int64_t>(it->second);
+    }
+    if (frozen) return -1;
+
+    auto candRange = candidateIndex.equal_range(hash);
+    for (auto it = candRange.first; it != candRange.second; ++it) {
+        auto cand = it->second;
+        if (cand->pixels.size() != size || std::memcmp(cand->pixels.data(), pixels, size) != 0) continue;
+        // 第二次出现：提升入库，候选记录随之删除。
+        size_t storeIndex = tiles.size();
+        candidateBytes -= cand->pixels.size();
+        tiles.push_back(std::move(cand->pixels));
+        index.emplace(hash, storeIndex);
+        candidates.erase(cand);
+        candidateIndex.erase(it);
+        return static_cast<int64_t>(storeIndex);
+    }
+
+    if (size > candidateBudget) return -1;
+    candidates.push_front(Candidate{hash, std::vector<uint8_t>(pixels, pixels + size)});
+    candidateIndex.emplace(hash, candidates.begin());
+    candidateBytes += size;
+    while (candidateBytes > candidateBudget) {
+        auto oldest = std::prev(candidates.end());
+        auto r = candidateIndex.equal_range(oldest->hash);
+        for (auto it = r.first; it != r.second; ++it) {
+            if (it->second == oldest) {
+                candidateIndex.erase(it);
+                break;
+            }
+        }
+        candidateBytes -= oldest->pixels.size();
+        candidates.erase(oldest);
+    }
+    return -1;
+}
+
+std::vector<uint8_t> Dedup::Store::tileAt(size_t i) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (i >= tiles.size()) throw std::runtime_error("Tile store index out of range");
+    return tiles[i];
+}
+
+size_t Dedup::Store::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tiles.size();
+}
+
+void Dedup::Store::save(const std::string &algoName, const std::string &path) const {
+    checkLossless(algoName);
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<uint8_t> out;
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    uint16_t tileSize = static_cast<uint16_t>(tile);
+    uint32_t count = static_cast<uint32_t>(tiles.size());
+    os.write("DDST", 4);
+    os.write(reinterpret_cast<const char*>(&tileSize), sizeof(uint16_t));
+    os.put(static_cast<char>(channels));
+    os.put(0);
+    os.write(reinterpret_cast<const char*>(&storeId), sizeof(uint64_t));
+    os.write(reinterpret_cast<const char*>(&count), sizeof(uint32_t));
+    std::vector<const std::vector<uint8_t>*> atlas;
+    atlas.reserve(tiles.size());
+    for (const auto &t : tiles) atlas.push_back(&t);
+    writeAtlas(os, algoName, atlas, tile, channels);
+    os.flush();
+    ImageIO::writeFile(path, out);
+}
+
+std::unique_ptr<Dedup::Store> Dedup::Store::load(const std::string &algoName, const std::string &path) {
+    MemProfile::Scope memScope("dedup");
+    std::vector<uint8_t> data = ImageIO::readFile(path);
+    if (data.size() < 28 || std::memcmp(data.data(), "DDST", 4) != 0) throw std::runtime_error("Invalid magic for tile store");
+    uint16_t tileSize = 0;
+    uint32_t count = 0;
+    std::memcpy(&tileSize, data.data() + 4, sizeof(uint16_t));
+    int cn = data[6];
+    auto store = std::unique_ptr<Store>(new Store(tileSize));
+    std::memcpy(&store->storeId, data.data() + 8, sizeof(uint64_t));
+    std::memcpy(&count, data.data() + 16, sizeof(uint32_t));
+    if (count > 0 && cn != 1 && cn != 3) throw std::runtime_error("Invalid tile store header");
+    size_t offset = 20;
+    store->tiles = readAtlas(algoName, data.data(), data.size(), offset, count, tileSize, cn);
+    store->channels = count ? cn : 0;
+    for (size_t i = 0; i < store->tiles.size(); ++i) {
+        store->index.emplace(hashTile(store->tiles[i].data(), store->tiles[i].size()), i);
+    }
+    return store;
+}
+
+bool Dedup::isDedup(const uint8_t *data, size_t size) {
+    return size >= 4 && std::memcmp(data, "DDUP", 4) == 0;
+}
+
+void Dedup::compress(const std::string &algoName, const cv::Mat &img, size_t tileSize, std::vector<uint8_t> &out,
+                     Store *store, Stats *stats) {
+    MemProfile::Scope memScope("dedup");
+    checkLossless(algoName);
+    checkTileSize(tileSize);
+    if (img.depth() != CV_8U || (img.channels() != 1 && img.channels() != 3)) {
+        throw std::runtime_error("Tile dedup supports 8-bit 1- or 3-channel images");
+    }
+    if (store && store->tileSize() != tileSize) {
+        throw std::runtime_error("Tile store uses " + std::to_string(store->tileSize()) + "-pixel tiles");
+    }
+    int cn = img.channels();
+    bool useStore = store && store->accepts(cn);
+    size_t tilesX = (img.cols + tileSize - 1) / tileSize, tilesY = (img.rows + tileSize - 1) / tileSize;
+    cv::Mat padded;
+    cv::copyMakeBorder(img, padded, 0, static_cast<int>(tilesY * tileSize) - img.rows,
+                       0, static_cast<int>(tilesX * tileSize) - img.cols, cv::BORDER_REPLICATE);
+
+    // 引用编码：0 = 图集中的下一个新块；1+2i = 本文件图集第 i 块；2+2i = 块库第 i 块。
+    Stats local;
+    std::vector<uint8_t> refs;
+    std::vector<std::vector<uint8_t>> atlasTiles;
+    std::unordered_multimap<uint64_t, size_t> seen;
+    size_t rowBytes = tileSize * cn;
+    std::vector<uint8_t> tileBuf(tileSize * rowBytes);
+    {
+        Progress::Section section(0, 2);
+        for (size_t ty = 0; ty < tilesY; ++ty) {
+            Progress::report(ty, tilesY);
+            for (size_t tx = 0; tx < tilesX; ++tx) {
+                for (size_t r = 0; r < tileSize; ++r) {
+                    std::memcpy(tileBuf.data() + r * rowBytes,
+                                padded.ptr<uint8_t>(static_cast<int>(ty * tileSize + r)) + tx * rowBytes, rowBytes);
+                }
+                ++local.tiles;
+                uint64_t h = hashTile(tileBuf.data(), tileBuf.size());
+                bool found = false;
+                auto range = seen.equal_range(h);
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (std::memcmp(atlasTiles[it->second].data(), tileBuf.data(), tileBuf.size()) == 0) {
+                        appendVarint(refs, 1 + 2 * static_cast<uint64_t>(it->second));
+                        ++local.localRepeats;
+                        found = true;
+                        break;
+                    }
+                }
+                if (found) continue;
+                if (useStore) {
+                    int64_t s = store->match(h, tileBuf.data(), tileBuf.size());
+                    if (s >= 0) {
+                        appendVarint(refs, 2 + 2 * static_cast<uint64_t>(s));
+                        ++local.storeRepeats;
+                        continue;
+                    }
+                }
+                seen.emplace(h, atlasTiles.size());
+                atlasTiles.push_back(tileBuf);
+                appendVarint(refs, 0);
+                ++local.unique;
+            }
+        }
+    }
+
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    uint32_t width = static_cast<uint32_t>(img.cols), height = static_cast<uint32_t>(img.rows);
+    uint16_t tile16 = static_cast<uint16_t>(tileSize);
+    uint64_t storeId = useStore && local.storeRepeats ? store->id() : 0;
+    uint32_t uniqueCount = static_cast<uint32_t>(atlasTiles.size());
+    uint32_t refBytes = static_cast<uint32_t>(refs.size());
+    os.write("DDUP", 4);
+    os.write(reinterpret_cast<const char*>(&width), sizeof(uint32_t));
+    os.write(reinterpret_cast<const char*>(&height), sizeof(uint32_t));
+    os.put(static_cast<char>(cn));
+    os.put(0);
+    os.write(reinterpret_cast<const char*>(&tile16), sizeof(uint16_t));
+    os.write(reinterpret_cast<const char*>(&storeId), sizeof(uint64_t));
+    os.write(reinterpret_cast<const char*>(&uniqueCount), sizeof(uint32_t));
+    os.write(reinterpret_cast<const char*>(&refBytes), sizeof(uint32_t));
+    os.write(reinterpret_cast<const char*>(refs.data()), static_cast<std::streamsize>(refs.size()));
+    {
+        Progress::Section section(1, 2);
+        std::vector<const std::vector<uint8_t>*> tiles;
+        tiles.reserve(atlasTiles.size());
+        for (const auto &t : atlasTiles) tiles.push_back(&t);
+        writeAtlas(os, algoName, tiles, tileSize, cn);
+    }
+    os.flush();
+    if (stats) *stats = local;
+}
+
+cv::Mat Dedup::decompress(const std::string &algoName, const uint8_t *data, size_t size, const Store *store) {
+    MemProfile::Scope memScope("dedup");
+    if (size < 32 || !isDedup(data, size)) throw std::runtime_error("Invalid magic for dedup");
+    uint32_t width = 0, height = 0, uniqueCount = 0, refBytes = 0;
+    uint16_t tile16 = 0;
+    uint64_t storeId = 0;
+    std::memcpy(&width, data + 4, sizeof(uint32_t));
+    std::memcpy(&height, data + 8, sizeof(uint32_t));
+    int cn = data[12];
+    std::memcpy(&tile16, data + 14, sizeof(uint16_t));
+    std::memcpy(&storeId, data + 16, sizeof(uint64_t));
+    std::memcpy(&uniqueCount, data + 24, sizeof(uint32_t));
+    std::memcpy(&refBytes, data + 28, sizeof(uint32_t));
+    size_t tileSize = tile16;
+    checkTileSize(tileSize);
+    if (cn != 1 && cn != 3) throw std::runtime_error("Invalid dedup header");
+    if (storeId != 0) {
+        if (!store) throw std::runtime_error("File references a shared tile store; pass it with --store");
+        if (store->id() != storeId || store->tileSize() != tileSize) {
+            throw std::runtime_error("Tile store does not match the one used for compression");
+        }
+    }
+    size_t offset = 32;
+    if (size - offset < refBytes) throw std::runtime_error("Truncated dedup tile references");
+    std::vector<uint8_t> refs(data + offset, data + offset + refBytes);
+    offset += refBytes;
+
+    std::vector<std::vector<uint8_t>> atlasTiles;
+    {
+        Progress::Section section(0, 2);
+        atlasTiles = readAtlas(algoName, data, size, offset, uniqueCount, tileSize, cn);
+    }
+    Progress::Section section(1, 2);
+    size_t tilesX = (width + tileSize - 1) / tileSize, tilesY = (height + tileSize - 1) / tileSize;
+    cv::Mat padded(static_cast<int>(tilesY * tileSize), static_cast<int>(tilesX * tileSize), CV_MAKETYPE(CV_8U, cn));
+    size_t rowBytes = tileSize * cn;
+    size_t pos = 0, nextNew = 0;
+    std::vector<uint8_t> storeTile;
+    for (size_t ty = 0; ty < tilesY; ++ty) {
+        Progress::report(ty, tilesY);
+        for (size_t tx = 0; tx < tilesX; ++tx) {
+            uint64_t ref = readVarint(refs, pos);
+            const std::vector<uint8_t> *src = nullptr;
+            if (ref == 0) {
+                if (nextNew >= atlasTiles.size()) throw std::runtime_error("Corrupted dedup tile references");
+                src = &atlasTiles[nextNew++];
+            } else if (ref & 1) {
+                uint64_t i = (ref - 1) / 2;
+                if (i >= nextNew) throw std::runtime_error("Corrupted dedup tile references");
+                src = &atlasTiles[i];
+            } else {
+                if (!store) throw std::runtime_error("Corrupted dedup tile references");
+                storeTile = store->tileAt(static_cast<size_t>((ref - 2) / 2));
+                src = &storeTile;
+                if (src->size() != tileSize * rowBytes) throw std::runtime_error("Tile store channel mismatch");
+            }
+            for (size_t r = 0; r < tileSize; ++r) {
+                std::memcpy(padded.ptr<uint8_t>(static_cast<int>(ty * tileSize + r)) + tx * rowBytes,
+                            src->data() + r * rowBytes, rowBytes);
+            }
+        }
+    }
+    return padded(cv::Rect(0, 0, static_cast<int>(width), static_cast<int>(height))).clone();
+}
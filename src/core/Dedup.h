@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Content-hash tile deduplication ("DDUP") for the lossless codecs.
+// 图像按固定大小切块（右/下边缘按复制边界补齐），每块计算 64 位非加密哈希，
+// 命中后逐字节比较确认。重复块只存引用（指向本文件更早的块或共享块库），
+// 只有首次出现的块拼成图集交给所选编解码器编码。
+namespace Dedup {
+const size_t kDefaultTileSize = 32;
+const size_t kDefaultCandidateBudget = 256u * 1024 * 1024; // 候选块像素字节上限
+
+uint64_t hashTile(const uint8_t *data, size_t size);
+
+// Shared tile store ("DDST") for a batch. A tile seen in one image is kept as a
+// candidate; when another image repeats it, it is promoted into the store and
+// referenced from then on. Store indices never change, so an existing store can
+// be loaded and extended by later batches.
+// 线程安全：批处理的多个编码线程共享同一个 Store。候选块的像素保存在内存中用于逐字节校验，
+// 总量受 candidateBudget 限制，超出时淘汰最早登记的候选块（被淘汰的块之后再出现只能重新登记）。
+// 已入库的块不受此限制，块库本身的大小取决于批内实际重复的内容。
+class Store {
+public:
+    explicit Store(size_t tileSize = kDefaultTileSize, size_t candidateBudget = kDefaultCandidateBudget);
+    // 文件由 save 写出；图集用 algoName 指定的无损编解码器编码。
+    static std::unique_ptr<Store> load(const std::string &algoName, const std::string &path);
+    void save(const std::string &algoName, const std::string &path) const;
+
+    uint64_t id() const { return storeId; }
+    size_t tileSize() const { return tile; }
+    // 冻结后 match 只查找已入库的块，不再登记候选或扩充块库（单张图像压缩时使用）。
+    void freeze() { frozen = true; }
+    // 首张使用 Store 的图像决定通道数，通道数不同的图像只做文件内去重。
+    bool accepts(int channels);
+    // 返回已入库或刚提升入库的块序号；未见过时登记为候选并返回 -1。
+    int64_t match(uint64_t hash, const uint8_t *pixels, size_t size);
+    // 按值返回：其他线程的 match 可能同时扩充块库并使内部存储重新分配。
+    std::vector<uint8_t> tileAt(size_t index) const;
+    size_t size() const;
+
+private:
+    struct Candidate {
+        uint64_t hash;
+        std::vector<uint8_t> pixels;
+    };
+    size_t tile;
+    size_t candidateBudget;
+    size_t candidateBytes = 0;
+    int channels = 0;
+    uint64_t storeId;
+    bool frozen = false;
+    mutable std::mutex mutex;
+    std::unordered_multimap<uint64_t, size_t> index; // 哈希 -> 块库序号
+    std::vector<std::vector<uint8_t>> tiles;          // 块库序号 -> 像素
+    std::list<Candidate> candidates;                  // 新登记的在前，超出预算时从尾部淘汰
+    std::unordered_multimap<uint64_t, std::list<Candidate>::iterator> candidateIndex;
+};
+
+struct Stats {
+    size_t tiles = 0;
+    size_t unique = 0;       // 写入本文件图集的块
+    size_t localRepeats = 0; // 引用本文件更早的块
+    size_t storeRepeats = 0; // 引用共享块库
+};
+
+// tileSize 需为 8-1024 之间的 8 的倍数。store 为空时只做文件内去重。仅支持无损算法。
+void compress(const std::string &algoName, const cv::Mat &img, size_t tileSize, std::vector<uint8_t> &out,
+              Store *store = nullptr, Stats *stats = nullptr);
+// 引用了块库的文件必须传入同一个 Store（按 ID 校验）。
+cv::Mat decompress(const std::string &algoName, const uint8_t *data, size_t size, const Store *store = nullptr);
+bool isDedup(const uint8_t *data, size_t size);
+}
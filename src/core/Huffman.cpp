@@ -1,8 +1,16 @@
 #include "Huffman.h"
-#include <fstream>
+#include "MemProfile.h"
+#include "MemoryStream.h"
+#include "Parallel.h"
+#include "Progress.h"
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
 #include <stdexcept>
 #include <sstream>
 #include <chrono>
+#include <functional>
 
 namespace {
 struct NodeCmp {
@@ -16,66 +24,406 @@ void freeTree(HuffmanNode *node) {
     delete node;
 }
 
-void buildCodes(HuffmanNode *node, std::vector<bool> &path, std::array<std::vector<bool>,256> &table) {
-    if (!node) return;
-    if (node->value >= 0) {
-        if (path.empty()) { // single symbol edge case
-            path.push_back(false);
+// HUFF 头部第一个填充字节为格式版本。
+const uint8_t kVersionLegacy = 0;  // 每通道一张 256 项 uint64 频率表，串行位流
+const uint8_t kVersionBlocked = 1; // 通道分块，每块独立的规范哈夫曼码长表
+const uint8_t kVersionShared = 2;  // 分块 + 引用外部共享码表（头部记录码表 ID 与校验和）
+const int kMaxCodeLen = 12;        // 限长后解码可用 4096 项查找表
+const size_t kPackedTableSize = 128; // 256 个 4 位码长
+
+// 由频率得到限长码长：先构造普通哈夫曼树求深度，超长时按 JPEG K.3 调整各长度的码字数，
+// 再把码长按频率从高到低重新分配给符号。
+std::array<uint8_t,256> buildCodeLengths(const std::array<uint32_t,256> &freq) {
+    std::array<uint8_t,256> lengths{};
+    std::vector<int> symbols;
+    for (int i = 0; i < 256; ++i) {
+        if (freq[i]) symbols.push_back(i);
+    }
+    if (symbols.empty()) return lengths;
+    if (symbols.size() == 1) {
+        lengths[symbols[0]] = 1;
+        return lengths;
+    }
+    size_t n = symbols.size();
+    std::vector<uint64_t> weight(2 * n - 1);
+    std::vector<int> parent(2 * n - 1, -1);
+    using Entry = std::pair<uint64_t, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pq;
+    for (size_t i = 0; i < n; ++i) {
+        weight[i] = freq[symbols[i]];
+        pq.push({weight[i], static_cast<int>(i)});
+    }
+    int nextNode = static_cast<int>(n);
+    while (pq.size() > 1) {
+        Entry a = pq.top(); pq.pop();
+        Entry b = pq.top(); pq.pop();
+        weight[nextNode] = a.first + b.first;
+        parent[a.second] = parent[b.second] = nextNode;
+        pq.push({weight[nextNode], nextNode});
+        ++nextNode;
+    }
+    std::vector<int> count(std::max<size_t>(n, kMaxCodeLen) + 1, 0);
+    int maxLen = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int depth = 0;
+        for (int p = parent[i]; p >= 0; p = parent[p]) ++depth;
+        count[depth]++;
+        maxLen = std::max(maxLen, depth);
+    }
+    for (int len = maxLen; len > kMaxCodeLen; ) {
+        if (count[len] == 0) {
+            --len;
+            continue;
         }
-        table[static_cast<uint8_t>(node->value)] = path;
-        return;
+        int j = len - 2;
+        while (count[j] == 0) --j;
+        count[len] -= 2;
+        count[len - 1] += 1;
+        count[j + 1] += 2;
+        count[j] -= 1;
+    }
+    std::sort(symbols.begin(), symbols.end(), [&](int a, int b) {
+        return freq[a] != freq[b] ? freq[a] > freq[b] : a < b;
+    });
+    size_t k = 0;
+    for (int len = 1; len <= kMaxCodeLen; ++len) {
+        for (int c = 0; c < count[len]; ++c) lengths[symbols[k++]] = static_cast<uint8_t>(len);
     }
-    path.push_back(false);
-    buildCodes(node->left, path, table);
-    path.back() = true;
-    buildCodes(node->right, path, table);
-    path.pop_back();
+    return lengths;
 }
+
+// 规范哈夫曼：按 (码长, 符号) 顺序依次分配码字。返回 false 表示码长表不合法。
+bool buildCanonicalCodes(const std::array<uint8_t,256> &lengths, std::array<uint16_t,256> &codes) {
+    int count[kMaxCodeLen + 1] = {0};
+    for (uint8_t l : lengths) {
+        if (l > kMaxCodeLen) return false;
+        count[l]++;
+    }
+    count[0] = 0;
+    uint32_t code = 0;
+    uint32_t nextCode[kMaxCodeLen + 1] = {0};
+    for (int len = 1; len <= kMaxCodeLen; ++len) {
+        code = (code + count[len - 1]) << 1;
+        nextCode[len] = code;
+        if (nextCode[len] + count[len] > (1u << len)) return false; // 违反 Kraft 不等式
+    }
+    for (int s = 0; s < 256; ++s) {
+        if (lengths[s]) codes[s] = static_cast<uint16_t>(nextCode[lengths[s]]++);
+    }
+    return true;
 }
 
-std::vector<uint8_t> Huffman::compressChannel(const std::vector<uint8_t> &data, uint64_t &validBits, std::array<uint64_t,256> &freqOut) {
-    freqOut.fill(0);
-    for (uint8_t v : data) freqOut[v]++;
+// CRC-32（IEEE）覆盖码长，用于确认解压时提供的共享码表与压缩时一致。
+uint32_t tableChecksum(const std::array<uint8_t,256> &lengths) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint8_t b : lengths) {
+        crc ^= b;
+        for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
 
-    std::priority_queue<HuffmanNode*, std::vector<HuffmanNode*>, NodeCmp> pq;
-    for (int i = 0; i < 256; ++i) {
-        if (freqOut[i] > 0) {
-            pq.push(new HuffmanNode{i, freqOut[i], nullptr, nullptr});
+// 64 位累加器的 MSB-first 位写入，结果与 BitWriter 的位序一致。
+class BlockBitWriter {
+public:
+    explicit BlockBitWriter(std::vector<uint8_t> &target) : out(target) {}
+    void put(uint32_t code, int len) {
+        acc = (acc << len) | code;
+        pending += len;
+        total += static_cast<uint64_t>(len);
+        while (pending >= 8) {
+            pending -= 8;
+            out.push_back(static_cast<uint8_t>(acc >> pending));
         }
     }
-    if (pq.empty()) throw std::runtime_error("Empty data for Huffman compression");
-    if (pq.size() == 1) {
-        // Duplicate single node to avoid zero-length codes
-        HuffmanNode *single = pq.top(); pq.pop();
-        HuffmanNode *dummy = new HuffmanNode{-1, single->freq, single, new HuffmanNode{single->value, single->freq, nullptr, nullptr}};
-        pq.push(dummy);
+    void flush() {
+        if (pending > 0) out.push_back(static_cast<uint8_t>(acc << (8 - pending)));
+        pending = 0;
     }
-    while (pq.size() > 1) {
-        HuffmanNode *a = pq.top(); pq.pop();
-        HuffmanNode *b = pq.top(); pq.pop();
-        HuffmanNode *parent = new HuffmanNode{-1, a->freq + b->freq, a, b};
-        pq.push(parent);
+    uint64_t bits() const { return total; }
+private:
+    std::vector<uint8_t> &out;
+    uint64_t acc = 0;
+    int pending = 0;
+    uint64_t total = 0;
+};
+
+void packLengths(const std::array<uint8_t,256> &lengths, uint8_t *packed) {
+    for (int s = 0; s < 256; s += 2) {
+        packed[s / 2] = static_cast<uint8_t>((lengths[s] << 4) | lengths[s + 1]);
     }
-    HuffmanNode *root = pq.top();
-    std::array<std::vector<bool>,256> codeTable;
-    std::vector<bool> path;
-    buildCodes(root, path, codeTable);
+}
 
-    std::stringstream ss;
-    ss.seekp(0);
-    BitWriter writer(ss);
-    for (uint8_t v : data) {
-        const auto &bits = codeTable[v];
-        for (bool b : bits) writer.writeBit(b ? 1 : 0);
+// 在 out 末尾写入 u64 有效位数 + 位流。
+void appendBits(const uint8_t *src, size_t size, const std::array<uint8_t,256> &lengths,
+                const std::array<uint16_t,256> &codes, std::vector<uint8_t> &out) {
+    size_t bitsOffset = out.size();
+    out.resize(out.size() + sizeof(uint64_t));
+    out.reserve(out.size() + size);
+    BlockBitWriter writer(out);
+    for (size_t i = 0; i < size; ++i) {
+        writer.put(codes[src[i]], lengths[src[i]]);
     }
     writer.flush();
-    validBits = writer.totalBitsWritten();
-    std::string str = ss.str();
-    std::vector<uint8_t> out(str.begin(), str.end());
-    freeTree(root);
+    uint64_t validBits = writer.bits();
+    std::memcpy(out.data() + bitsOffset, &validBits, sizeof(uint64_t));
+}
+
+void appendDynamicBlock(const uint8_t *src, size_t size, std::vector<uint8_t> &out) {
+    std::array<uint32_t,256> freq;
+    Huffman::histogram(src, size, freq);
+    std::array<uint8_t,256> lengths = buildCodeLengths(freq);
+    std::array<uint16_t,256> codes{};
+    buildCanonicalCodes(lengths, codes);
+    size_t tableOffset = out.size();
+    out.resize(out.size() + kPackedTableSize);
+    packLengths(lengths, out.data() + tableOffset);
+    appendBits(src, size, lengths, codes, out);
+}
+
+// 共享码表模式下每块的码表类型字节。
+const uint8_t kBlockDynamic = 0; // 后随 128 字节自有码长表
+const uint8_t kBlockShared = 1;  // 直接使用共享码表
+const size_t kSampleStride = 16; // 选择码表时的抽样步长
+
+struct SharedCoder {
+    const Huffman::SharedTable &table;
+    std::array<uint16_t,256> codes{};
+    explicit SharedCoder(const Huffman::SharedTable &t) : table(t) {
+        if (!buildCanonicalCodes(table.lengths, codes)) throw std::runtime_error("Invalid shared Huffman table");
+    }
+};
+
+void encodeBlock(const uint8_t *src, size_t size, std::vector<uint8_t> &out, const SharedCoder *shared) {
+    out.clear();
+    if (!shared) {
+        appendDynamicBlock(src, size, out);
+        return;
+    }
+    // 只统计抽样字节，估算共享码表与自适应码表（另加 128 字节码表开销）的代价，
+    // 共享码表更划算时整块只需一次编码遍历。
+    std::array<uint32_t,256> sample{};
+    for (size_t i = 0; i < size; i += kSampleStride) sample[src[i]]++;
+    std::array<uint8_t,256> dynamicLengths = buildCodeLengths(sample);
+    uint64_t sharedBits = 0, dynamicBits = 0;
+    for (int s = 0; s < 256; ++s) {
+        sharedBits += static_cast<uint64_t>(sample[s]) * shared->table.lengths[s];
+        dynamicBits += static_cast<uint64_t>(sample[s]) * dynamicLengths[s];
+    }
+    if (sharedBits * kSampleStride <= dynamicBits * kSampleStride + kPackedTableSize * 8) {
+        out.push_back(kBlockShared);
+        appendBits(src, size, shared->table.lengths, shared->codes, out);
+    } else {
+        out.push_back(kBlockDynamic);
+        appendDynamicBlock(src, size, out);
+    }
+}
+
+void decodeBlock(const uint8_t *table, const uint8_t *bits, uint64_t validBits, uint8_t *dst, size_t size) {
+    std::array<uint8_t,256> lengths;
+    for (int s = 0; s < 256; s += 2) {
+        lengths[s] = table[s / 2] >> 4;
+        lengths[s + 1] = table[s / 2] & 0x0F;
+    }
+    std::array<uint16_t,256> codes{};
+    if (!buildCanonicalCodes(lengths, codes)) throw std::runtime_error("Invalid Huffman block table");
+    // 查找表项：低 8 位为符号，高位为码长；码长 0 表示非法前缀。
+    std::vector<uint16_t> lut(1u << kMaxCodeLen, 0);
+    for (int s = 0; s < 256; ++s) {
+        int len = lengths[s];
+        if (!len) continue;
+        uint32_t first = static_cast<uint32_t>(codes[s]) << (kMaxCodeLen - len);
+        uint32_t span = 1u << (kMaxCodeLen - len);
+        for (uint32_t k = 0; k < span; ++k) lut[first + k] = static_cast<uint16_t>((len << 8) | s);
+    }
+
+    const uint8_t *p = bits;
+    const uint8_t *end = bits + (validBits + 7) / 8;
+    uint64_t buf = 0;
+    int avail = 0;
+    uint64_t consumed = 0;
+    for (size_t i = 0; i < size; ++i) {
+        while (avail <= 56) {
+            uint64_t byte = p < end ? *p++ : 0;
+            buf |= byte << (56 - avail);
+            avail += 8;
+        }
+        uint16_t entry = lut[buf >> (64 - kMaxCodeLen)];
+        int len = entry >> 8;
+        if (len == 0) throw std::runtime_error("Corrupted Huffman block");
+        dst[i] = static_cast<uint8_t>(entry & 0xFF);
+        buf <<= len;
+        avail -= len;
+        consumed += static_cast<uint64_t>(len);
+    }
+    if (consumed > validBits) throw std::runtime_error("Corrupted Huffman block");
+}
+}
+
+void Huffman::histogram(const uint8_t *data, size_t size, std::array<uint32_t,256> &freq) {
+    // 四张计数表交替累加，消除相邻相同字节造成的写后读依赖，循环按 4 字节展开。
+    uint32_t t0[256] = {0}, t1[256] = {0}, t2[256] = {0}, t3[256] = {0};
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        t0[data[i]]++;
+        t1[data[i + 1]]++;
+        t2[data[i + 2]]++;
+        t3[data[i + 3]]++;
+    }
+    for (; i < size; ++i) t0[data[i]]++;
+    for (int v = 0; v < 256; ++v) freq[v] = t0[v] + t1[v] + t2[v] + t3[v];
+}
+
+void Huffman::encodeBlocks(const std::vector<uint8_t> &data, std::ostream &out, size_t blockSize, const SharedTable *table) {
+    if (blockSize == 0) blockSize = kDefaultBlockSize;
+    std::unique_ptr<SharedCoder> shared;
+    if (table) shared = std::make_unique<SharedCoder>(*table);
+    uint32_t blockSize32 = static_cast<uint32_t>(blockSize);
+    uint32_t blockCount = static_cast<uint32_t>((data.size() + blockSize - 1) / blockSize);
+    out.write(reinterpret_cast<const char*>(&blockSize32), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(&blockCount), sizeof(uint32_t));
+    std::vector<std::vector<uint8_t>> encoded(blockCount);
+    Parallel::forEach(blockCount, [&](size_t b) {
+        size_t start = b * blockSize;
+        size_t len = std::min(blockSize, data.size() - start);
+        encodeBlock(data.data() + start, len, encoded[b], shared.get());
+    });
+    // 每块：[码表类型] + [码长表(128B)] + 有效位数(u64) + 位流；码表类型仅在共享码表模式下出现
+    for (const auto &blk : encoded) {
+        out.write(reinterpret_cast<const char*>(blk.data()), static_cast<std::streamsize>(blk.size()));
+    }
+}
+
+std::vector<uint8_t> Huffman::decodeBlocks(std::istream &in, size_t rawSize, const SharedTable *table) {
+    uint32_t blockSize = 0, blockCount = 0;
+    in.read(reinterpret_cast<char*>(&blockSize), sizeof(uint32_t));
+    in.read(reinterpret_cast<char*>(&blockCount), sizeof(uint32_t));
+    if (!in || blockSize == 0 || blockCount != (rawSize + blockSize - 1) / blockSize) {
+        throw std::runtime_error("Invalid Huffman block layout");
+    }
+    uint8_t sharedPacked[kPackedTableSize];
+    if (table) packLengths(table->lengths, sharedPacked);
+    // 先顺序读出所有块，记录各自偏移，再并行解码到输出缓冲区的对应位置。
+    struct BlockRef { size_t tableOffset; uint64_t validBits; size_t dataOffset; };
+    std::vector<BlockRef> refs(blockCount);
+    std::vector<uint8_t> payload;
+    for (auto &ref : refs) {
+        uint8_t header[kPackedTableSize + sizeof(uint64_t)];
+        bool useShared = false;
+        if (table) {
+            int kind = in.get();
+            if (kind != kBlockDynamic && kind != kBlockShared) throw std::runtime_error("Invalid Huffman block table kind");
+            useShared = kind == kBlockShared;
+        }
+        if (useShared) {
+            std::memcpy(header, sharedPacked, kPackedTableSize);
+            in.read(reinterpret_cast<char*>(header + kPackedTableSize), sizeof(uint64_t));
+        } else {
+            in.read(reinterpret_cast<char*>(header), sizeof(header));
+        }
+        if (!in) throw std::runtime_error("Truncated Huffman block");
+        std::memcpy(&ref.validBits, header + kPackedTableSize, sizeof(uint64_t));
+        size_t bytes = static_cast<size_t>((ref.validBits + 7) / 8);
+        ref.tableOffset = payload.size();
+        payload.insert(payload.end(), header, header + kPackedTableSize);
+        ref.dataOffset = payload.size();
+        payload.resize(payload.size() + bytes);
+        in.read(reinterpret_cast<char*>(payload.data() + ref.dataOffset), static_cast<std::streamsize>(bytes));
+        if (!in) throw std::runtime_error("Truncated Huffman block");
+    }
+    std::vector<uint8_t> out(rawSize);
+    Parallel::forEach(blockCount, [&](size_t b) {
+        size_t start = b * blockSize;
+        size_t len = std::min<size_t>(blockSize, rawSize - start);
+        decodeBlock(payload.data() + refs[b].tableOffset, payload.data() + refs[b].dataOffset,
+                    refs[b].validBits, out.data() + start, len);
+    });
     return out;
 }
 
+uint64_t Huffman::encodedBlocksSize(const std::vector<uint8_t> &data, size_t blockSize) {
+    if (blockSize == 0) blockSize = kDefaultBlockSize;
+    uint64_t bytes = 2 * sizeof(uint32_t);
+    for (size_t start = 0; start < data.size(); start += blockSize) {
+        size_t len = std::min(blockSize, data.size() - start);
+        std::array<uint32_t,256> freq;
+        histogram(data.data() + start, len, freq);
+        std::array<uint8_t,256> lengths = buildCodeLengths(freq);
+        uint64_t bits = 0;
+        for (int s = 0; s < 256; ++s) bits += static_cast<uint64_t>(freq[s]) * lengths[s];
+        bytes += kPackedTableSize + sizeof(uint64_t) + (bits + 7) / 8;
+    }
+    return bytes;
+}
+
+void Huffman::addTrainingSample(const cv::Mat &img, std::array<uint64_t,256> &freq) {
+    ImageData data = ImageIO::fromMat(img);
+    std::array<uint32_t,256> chunkFreq;
+    for (const auto &channel : data.channelData) {
+        for (size_t start = 0; start < channel.size(); start += kDefaultBlockSize) {
+            histogram(channel.data() + start, std::min(kDefaultBlockSize, channel.size() - start), chunkFreq);
+            for (int v = 0; v < 256; ++v) freq[v] += chunkFreq[v];
+        }
+    }
+}
+
+Huffman::SharedTable Huffman::buildSharedTable(const std::array<uint64_t,256> &freq) {
+    // 缩放到 32 位并对每个符号加 1，保证任意图像的所有字节都有码字。
+    uint64_t maxFreq = *std::max_element(freq.begin(), freq.end());
+    int shift = 0;
+    while ((maxFreq >> shift) >= (1u << 24)) ++shift;
+    std::array<uint32_t,256> scaled;
+    for (int v = 0; v < 256; ++v) scaled[v] = static_cast<uint32_t>(freq[v] >> shift) + 1;
+
+    SharedTable table;
+    table.lengths = buildCodeLengths(scaled);
+    uint64_t id = 1469598103934665603ull; // FNV-1a：同一训练统计得到同一 ID
+    for (uint64_t f : freq) {
+        for (int i = 0; i < 8; ++i) {
+            id ^= (f >> (8 * i)) & 0xFF;
+            id *= 1099511628211ull;
+        }
+    }
+    table.id = id;
+    table.checksum = tableChecksum(table.lengths);
+    return table;
+}
+
+void Huffman::saveTable(const std::string &path, const SharedTable &table) {
+    std::vector<uint8_t> bytes;
+    VectorStreamBuf buf(bytes);
+    std::ostream os(&buf);
+    os.write("HFT ", 4);
+    os.put(0); os.put(0); os.put(0); os.put(0);
+    os.write(reinterpret_cast<const char*>(&table.id), sizeof(uint64_t));
+    os.write(reinterpret_cast<const char*>(&table.checksum), sizeof(uint32_t));
+    uint8_t packed[kPackedTableSize];
+    packLengths(table.lengths, packed);
+    os.write(reinterpret_cast<const char*>(packed), kPackedTableSize);
+    ImageIO::writeFile(path, bytes);
+}
+
+Huffman::SharedTable Huffman::loadTable(const std::string &path) {
+    std::vector<uint8_t> bytes = ImageIO::readFile(path);
+    if (bytes.size() != 4 + 4 + 8 + 4 + kPackedTableSize || std::memcmp(bytes.data(), "HFT ", 4) != 0) {
+        throw std::runtime_error("Invalid Huffman table file: " + path);
+    }
+    SharedTable table;
+    std::memcpy(&table.id, bytes.data() + 8, sizeof(uint64_t));
+    std::memcpy(&table.checksum, bytes.data() + 16, sizeof(uint32_t));
+    const uint8_t *packed = bytes.data() + 20;
+    for (int s = 0; s < 256; s += 2) {
+        table.lengths[s] = packed[s / 2] >> 4;
+        table.lengths[s + 1] = packed[s / 2] & 0x0F;
+    }
+    std::array<uint16_t,256> codes{};
+    if (tableChecksum(table.lengths) != table.checksum || !buildCanonicalCodes(table.lengths, codes) ||
+        std::count(table.lengths.begin(), table.lengths.end(), 0) != 0) {
+        throw std::runtime_error("Corrupted Huffman table file: " + path);
+    }
+    return table;
+}
+
 static HuffmanNode* buildTreeFromFreq(const std::array<uint64_t,256> &freq) {
     std::priority_queue<HuffmanNode*, std::vector<HuffmanNode*>, NodeCmp> pq;
     for (int i = 0; i < 256; ++i) {
@@ -103,6 +451,7 @@ std::vector<uint8_t> Huffman::decompressChannel(const std::vector<uint8_t> &enco
     std::vector<uint8_t> output;
     HuffmanNode *cur = root;
     for (uint64_t i = 0; i < validBits; ++i) {
+        if (i % (Progress::kReportInterval * 8) == 0) Progress::report(i, validBits);
         int bit;
         if (!reader.readBit(bit)) break;
         cur = (bit == 0) ? cur->left : cur->right;
@@ -116,31 +465,69 @@ std::vector<uint8_t> Huffman::decompressChannel(const std::vector<uint8_t> &enco
 }
 
 void Huffman::compress(const cv::Mat &img, const std::string &outputPath) {
-    ImageData data = ImageIO::fromMat(img);
-    std::ofstream ofs(outputPath, std::ios::binary);
-    if (!ofs) throw std::runtime_error("Cannot open output file");
+    std::vector<uint8_t> buffer;
+    compress(img, buffer);
+    ImageIO::writeFile(outputPath, buffer);
+}
+
+void Huffman::compress(const cv::Mat &img, std::vector<uint8_t> &out) {
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    compress(img, os);
+}
+
+void Huffman::compress(const cv::Mat &img, std::ostream &ofs) {
+    compress(img, ofs, nullptr);
+}
+
+void Huffman::compress(const cv::Mat &img, std::vector<uint8_t> &out, const SharedTable *table) {
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    compress(img, os, table);
+}
+
+void Huffman::compress(const cv::Mat &img, std::ostream &ofs, const SharedTable *table) {
+    MemProfile::Scope memScope("huffman");
+    ImageData data = ImageIO::fromMat(img, ColorTransform::current());
     ofs.write("HUFF", 4);
     ofs.write(reinterpret_cast<const char*>(&data.width), sizeof(uint32_t));
     ofs.write(reinterpret_cast<const char*>(&data.height), sizeof(uint32_t));
     ofs.put(static_cast<char>(data.channels));
-    ofs.put(0); ofs.put(0); ofs.put(0);
+    ofs.put(static_cast<char>(table ? kVersionShared : kVersionBlocked));
+    ofs.put(static_cast<char>(data.transform)); ofs.put(0);
+    if (table) {
+        ofs.write(reinterpret_cast<const char*>(&table->id), sizeof(uint64_t));
+        ofs.write(reinterpret_cast<const char*>(&table->checksum), sizeof(uint32_t));
+    }
     for (size_t c = 0; c < data.channelData.size(); ++c) {
-        uint64_t validBits = 0;
-        std::array<uint64_t,256> freq;
-        auto encoded = compressChannel(data.channelData[c], validBits, freq);
-        for (uint64_t f : freq) {
-            ofs.write(reinterpret_cast<const char*>(&f), sizeof(uint64_t));
-        }
-        ofs.write(reinterpret_cast<const char*>(&validBits), sizeof(uint64_t));
-        uint32_t sz = static_cast<uint32_t>(encoded.size());
-        ofs.write(reinterpret_cast<const char*>(&sz), sizeof(uint32_t));
-        ofs.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+        Progress::Section section(c, data.channelData.size());
+        encodeBlocks(data.channelData[c], ofs, kDefaultBlockSize, table);
     }
 }
 
 cv::Mat Huffman::decompress(const std::string &inputPath) {
-    std::ifstream ifs(inputPath, std::ios::binary);
-    if (!ifs) throw std::runtime_error("Cannot open input file");
+    std::vector<uint8_t> buffer = ImageIO::readFile(inputPath);
+    return decompress(buffer.data(), buffer.size());
+}
+
+cv::Mat Huffman::decompress(const uint8_t *data, size_t size) {
+    return decompress(data, size, nullptr);
+}
+
+cv::Mat Huffman::decompress(const uint8_t *data, size_t size, const SharedTable *table) {
+    SpanStreamBuf buf(data, size);
+    std::istream is(&buf);
+    return decompress(is, table);
+}
+
+cv::Mat Huffman::decompress(std::istream &ifs) {
+    return decompress(ifs, nullptr);
+}
+
+cv::Mat Huffman::decompress(std::istream &ifs, const SharedTable *table) {
+    MemProfile::Scope memScope("huffman");
     char magic[4];
     ifs.read(magic, 4);
     if (std::string(magic, 4) != "HUFF") throw std::runtime_error("Invalid magic for Huffman");
@@ -149,8 +536,34 @@ cv::Mat Huffman::decompress(const std::string &inputPath) {
     ifs.read(reinterpret_cast<char*>(&data.height), sizeof(uint32_t));
     ifs.read(reinterpret_cast<char*>(&data.channels), 1);
     char pad[3]; ifs.read(pad, 3);
+    uint8_t version = static_cast<uint8_t>(pad[0]);
+    if (version != kVersionLegacy && version != kVersionBlocked && version != kVersionShared) {
+        throw std::runtime_error("Unsupported Huffman format version");
+    }
+    if (!ColorTransform::isKnown(static_cast<uint8_t>(pad[1]))) throw std::runtime_error("Unsupported Huffman colour transform");
+    data.transform = static_cast<ColorTransform::Kind>(pad[1]);
+    if (version == kVersionShared) {
+        uint64_t id = 0; uint32_t checksum = 0;
+        ifs.read(reinterpret_cast<char*>(&id), sizeof(uint64_t));
+        ifs.read(reinterpret_cast<char*>(&checksum), sizeof(uint32_t));
+        if (!table) {
+            std::ostringstream msg;
+            msg << "File requires shared Huffman table " << std::hex << id;
+            throw std::runtime_error(msg.str());
+        }
+        if (table->id != id || table->checksum != checksum) {
+            throw std::runtime_error("Shared Huffman table does not match the one used for compression");
+        }
+    } else {
+        table = nullptr;
+    }
     data.channelData.resize(data.channels);
     for (size_t c = 0; c < data.channelData.size(); ++c) {
+        Progress::Section section(c, data.channelData.size());
+        if (version != kVersionLegacy) {
+            data.channelData[c] = decodeBlocks(ifs, static_cast<size_t>(data.width) * data.height, table);
+            continue;
+        }
         std::array<uint64_t,256> freq;
         for (uint64_t &f : freq) {
             ifs.read(reinterpret_cast<char*>(&f), sizeof(uint64_t));
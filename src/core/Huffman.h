@@ -6,6 +6,7 @@
 #include <memory>
 #include <string>
 #include <array>
+#include <iosfwd>
 #include "ImageData.h"
 #include "BitIO.h"
 
@@ -18,9 +19,44 @@ struct HuffmanNode {
 
 // Huffman coding for byte streams.
 namespace Huffman {
-std::vector<uint8_t> compressChannel(const std::vector<uint8_t> &data, uint64_t &validBits, std::array<uint64_t,256> &freqOut);
 std::vector<uint8_t> decompressChannel(const std::vector<uint8_t> &encoded, uint64_t validBits, const std::array<uint64_t,256> &freq);
 
+// 四表展开计数的字节直方图；单次调用的数据量需小于 4GB。
+void histogram(const uint8_t *data, size_t size, std::array<uint32_t,256> &freq);
+
+// Block-partitioned coding: each block carries its own 4-bit-per-symbol canonical
+// code-length table and bit count, so blocks adapt to local statistics and are
+// encoded/decoded in parallel.
+constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+// Pretrained table shared by a corpus of similar images. Every symbol has a code,
+// so blocks can be coded in a single pass without a histogram or a stored table.
+// 文件只记录码表 ID 与校验和；与共享码表匹配较差的块仍回退到自适应码表。
+struct SharedTable {
+    uint64_t id = 0;
+    uint32_t checksum = 0; // 码长的 CRC-32
+    std::array<uint8_t,256> lengths{};
+};
+void addTrainingSample(const cv::Mat &img, std::array<uint64_t,256> &freq);
+SharedTable buildSharedTable(const std::array<uint64_t,256> &freq);
+void saveTable(const std::string &path, const SharedTable &table);
+SharedTable loadTable(const std::string &path);
+
+// table 非空时每块前多一个码表类型字节，解码端必须传入同一张共享码表。
+void encodeBlocks(const std::vector<uint8_t> &data, std::ostream &out, size_t blockSize = kDefaultBlockSize,
+                  const SharedTable *table = nullptr);
+std::vector<uint8_t> decodeBlocks(std::istream &in, size_t rawSize, const SharedTable *table = nullptr);
+// encodeBlocks（无共享码表）输出的精确字节数，只统计直方图与码长，不实际编码。
+uint64_t encodedBlocksSize(const std::vector<uint8_t> &data, size_t blockSize = kDefaultBlockSize);
+
 void compress(const cv::Mat &img, const std::string &outputPath);
+void compress(const cv::Mat &img, std::ostream &out);
+void compress(const cv::Mat &img, std::vector<uint8_t> &out);
+void compress(const cv::Mat &img, std::ostream &out, const SharedTable *table);
+void compress(const cv::Mat &img, std::vector<uint8_t> &out, const SharedTable *table);
 cv::Mat decompress(const std::string &inputPath);
+cv::Mat decompress(std::istream &in);
+cv::Mat decompress(const uint8_t *data, size_t size);
+cv::Mat decompress(std::istream &in, const SharedTable *table);
+cv::Mat decompress(const uint8_t *data, size_t size, const SharedTable *table);
 }
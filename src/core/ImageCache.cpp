@@ -0,0 +1,107 @@
+#include "ImageCache.h"
+#include "Decompressor.h"
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+
+ImageCache::ImageCache() : ImageCache(Config()) {}
+
+ImageCache::ImageCache(Config cfg) : config(cfg) {
+    if (config.shards == 0) config.shards = 1;
+    for (size_t i = 0; i < config.shards; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+size_t ImageCache::shardFor(const std::string &key) const {
+    return std::hash<std::string>{}(key) % shards.size();
+}
+
+void ImageCache::evictTail(Shard &shard) {
+    Entry &victim = shard.lru.back();
+    shard.bytes -= victim.bytes;
+    totalBytes -= victim.bytes;
+    shard.index.erase(victim.key);
+    shard.lru.pop_back();
+    shard.evictions++;
+}
+
+cv::Mat ImageCache::decompress(const std::string &algoName, const std::string &inputPath) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    auto mtime = fs::last_write_time(inputPath, ec);
+    uint64_t size = ec ? 0 : fs::file_size(inputPath, ec);
+    if (ec) throw std::runtime_error("Cannot stat file: " + inputPath);
+
+    std::string key = algoName + '\n' + inputPath + '\n' +
+                      std::to_string(mtime.time_since_epoch().count()) + '\n' + std::to_string(size);
+    size_t home = shardFor(key);
+    Shard &shard = *shards[home];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            shard.hits++;
+            return it->second->image;
+        }
+        shard.misses++;
+    }
+
+    // 解码在锁外进行，慢文件不会阻塞同分片的其他命中。
+    cv::Mat image = Decompressor::decompressImage(algoName, inputPath);
+    size_t bytes = image.total() * image.elemSize();
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (bytes > config.byteBudget) {
+            shard.uncacheable++;
+            return image;
+        }
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.bytes -= it->second->bytes;
+            totalBytes -= it->second->bytes;
+            shard.lru.erase(it->second);
+            shard.index.erase(it);
+        }
+        // 先淘汰本分片的旧项，再插入新项。
+        while (totalBytes + bytes > config.byteBudget && !shard.lru.empty()) evictTail(shard);
+        shard.lru.push_front({key, image, bytes});
+        shard.index[key] = shard.lru.begin();
+        shard.bytes += bytes;
+        totalBytes += bytes;
+    }
+    // 仍超出预算时依次从其他分片尾部淘汰，每次只持有一个分片的锁，避免锁顺序死锁。
+    for (size_t i = 1; i < shards.size() && totalBytes > config.byteBudget; ++i) {
+        Shard &other = *shards[(home + i) % shards.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        while (totalBytes > config.byteBudget && !other.lru.empty()) evictTail(other);
+    }
+    return image;
+}
+
+void ImageCache::clear() {
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->lru.clear();
+        shard->index.clear();
+        totalBytes -= shard->bytes;
+        shard->bytes = 0;
+    }
+}
+
+ImageCache::Stats ImageCache::stats() const {
+    Stats s;
+    s.byteBudget = config.byteBudget;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        s.hits += shard->hits;
+        s.misses += shard->misses;
+        s.evictions += shard->evictions;
+        s.uncacheable += shard->uncacheable;
+        s.entries += shard->lru.size();
+        s.bytes += shard->bytes;
+    }
+    return s;
+}
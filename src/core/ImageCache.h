@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Decoded-image cache in front of Decompressor for processes that decode the
+// same files repeatedly (preview services, the serve daemon).
+// 键为 算法 + 路径 + 修改时间 + 文件大小，文件被改写后自然失效；按键哈希分片，每片独立加锁的 LRU。
+// 字节预算是全局的：单张图像只要不超过 byteBudget 就能入缓存，本分片腾不出空间时再从其他分片尾部淘汰。
+class ImageCache {
+public:
+    struct Config {
+        size_t byteBudget = 256u * 1024 * 1024; // 所有分片合计的像素字节上限，也是单张图像的上限
+        size_t shards = 16;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t uncacheable = 0; // 单张图像超过总预算，解码后直接返回不入缓存
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t byteBudget = 0;
+    };
+
+    ImageCache();
+    explicit ImageCache(Config cfg);
+
+    // 命中时直接返回缓存的图像，未命中时解码并插入。返回的 Mat 与缓存共享像素，修改前需 clone()。
+    // 并发的同键未命中可能各自解码一次，结果相同，后插入的覆盖先插入的。
+    cv::Mat decompress(const std::string &algoName, const std::string &inputPath);
+
+    void clear();
+    Stats stats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        cv::Mat image;
+        size_t bytes;
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru; // 头部为最近使用
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t uncacheable = 0;
+    };
+
+    size_t shardFor(const std::string &key) const;
+    // 调用方持有 shard.mutex；淘汰该分片最久未使用的一项。
+    void evictTail(Shard &shard);
+
+    Config config;
+    std::atomic<size_t> totalBytes{0};
+    std::vector<std::unique_ptr<Shard>> shards;
+};
@@ -1,8 +1,11 @@
 #include "ImageData.h"
+#include "MemProfile.h"
 #include <stdexcept>
 #include <cstring>
+#include <fstream>
 
 cv::Mat ImageIO::loadImage(const std::string &path, bool forceColor) {
+    MemProfile::Scope memScope("load");
     cv::Mat img = cv::imread(path, forceColor ? cv::IMREAD_COLOR : cv::IMREAD_UNCHANGED);
     // 读取失败直接抛出异常，由上层统一处理。
     if (img.empty()) {
@@ -19,17 +22,24 @@ cv::Mat ImageIO::loadImage(const std::string &path, bool forceColor) {
 }
 
 void ImageIO::saveImage(const std::string &path, const cv::Mat &img) {
+    MemProfile::Scope memScope("save");
     // 写盘失败同样抛出异常，保证调用方获知失败原因。
     if (!cv::imwrite(path, img)) {
         throw std::runtime_error("Failed to write image: " + path);
     }
 }
 
-ImageData ImageIO::fromMat(const cv::Mat &img) {
+ImageData ImageIO::fromMat(const cv::Mat &img, ColorTransform::Kind transform) {
+    MemProfile::Scope memScope("planar");
     ImageData data;
     data.width = static_cast<uint32_t>(img.cols);
     data.height = static_cast<uint32_t>(img.rows);
     data.channels = static_cast<uint8_t>(img.channels());
+    if (data.channels == 3 && transform != ColorTransform::Kind::None) {
+        data.transform = transform;
+        ColorTransform::forward(img, data.channelData);
+        return data;
+    }
     // 将多通道图像拆分成独立向量，方便逐通道压缩。
     std::vector<cv::Mat> planes;
     if (data.channels == 3) {
@@ -45,6 +55,10 @@ ImageData ImageIO::fromMat(const cv::Mat &img) {
 }
 
 cv::Mat ImageIO::toMat(const ImageData &data) {
+    MemProfile::Scope memScope("planar");
+    if (data.channels == 3 && data.transform != ColorTransform::Kind::None) {
+        return ColorTransform::inverse(data.channelData, static_cast<int>(data.width), static_cast<int>(data.height));
+    }
     std::vector<cv::Mat> planes;
     planes.reserve(data.channelData.size());
     // 将存储的字节数据还原成 OpenCV 矩阵。
@@ -60,3 +74,22 @@ cv::Mat ImageIO::toMat(const ImageData &data) {
     }
     return planes[0];
 }
+
+std::vector<uint8_t> ImageIO::readFile(const std::string &path) {
+    MemProfile::Scope memScope("file-io");
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+    if (!ifs) throw std::runtime_error("Cannot open input file");
+    std::vector<uint8_t> bytes(static_cast<size_t>(ifs.tellg()));
+    ifs.seekg(0);
+    ifs.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!ifs) throw std::runtime_error("Failed to read input file");
+    return bytes;
+}
+
+void ImageIO::writeFile(const std::string &path, const std::vector<uint8_t> &bytes) {
+    MemProfile::Scope memScope("file-io");
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs) throw std::runtime_error("Cannot open output file");
+    ofs.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!ofs) throw std::runtime_error("Failed to write output file");
+}
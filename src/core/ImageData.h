@@ -1,5 +1,6 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include "ColorTransform.h"
 #include <string>
 #include <vector>
 
@@ -8,12 +9,17 @@ struct ImageData {
     uint32_t width = 0;
     uint32_t height = 0;
     uint8_t channels = 0; // 1 or 3
+    ColorTransform::Kind transform = ColorTransform::Kind::None; // 三通道时 channelData 为 Y/Co/Cg
     std::vector<std::vector<uint8_t>> channelData; // per-channel byte array
 };
 
 namespace ImageIO {
 cv::Mat loadImage(const std::string &path, bool forceColor);
 void saveImage(const std::string &path, const cv::Mat &img);
-ImageData fromMat(const cv::Mat &img);
+// transform 仅对三通道图像生效，单通道图像始终不做变换。
+ImageData fromMat(const cv::Mat &img, ColorTransform::Kind transform = ColorTransform::Kind::None);
 cv::Mat toMat(const ImageData &data);
+// 整文件读写，供基于内存缓冲区的编解码入口使用。
+std::vector<uint8_t> readFile(const std::string &path);
+void writeFile(const std::string &path, const std::vector<uint8_t> &bytes);
 }
@@ -0,0 +1,179 @@
+#include "JFIF.h"
+#include "Progress.h"
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+// T.81 K.3 表 K.3 / K.5：亮度 DC 与 AC 的码长计数（BITS）与符号（HUFFVAL）。
+const uint8_t kDcBits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+const uint8_t kDcVals[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+const uint8_t kAcBits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+const uint8_t kAcVals[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+struct Code {
+    uint16_t bits = 0;
+    uint8_t length = 0;
+};
+
+// 由 BITS/HUFFVAL 生成规范哈夫曼码（T.81 C.2）。
+std::vector<Code> buildCodes(const uint8_t bits[16], const uint8_t *vals) {
+    std::vector<Code> table(256);
+    uint16_t code = 0;
+    size_t k = 0;
+    for (int len = 1; len <= 16; ++len) {
+        for (int i = 0; i < bits[len - 1]; ++i) {
+            table[vals[k++]] = Code{code, static_cast<uint8_t>(len)};
+            ++code;
+        }
+        code <<= 1;
+    }
+    return table;
+}
+
+// 熵编码段的位写入：高位在前，输出 0xFF 后补 0x00（字节填充）。
+class BitWriter {
+public:
+    explicit BitWriter(std::ostream &o) : out(o) {}
+    void put(uint32_t value, int count) {
+        acc = (acc << count) | (value & ((1u << count) - 1));
+        used += count;
+        while (used >= 8) {
+            uint8_t byte = static_cast<uint8_t>(acc >> (used - 8));
+            out.put(static_cast<char>(byte));
+            if (byte == 0xFF) out.put(0);
+            used -= 8;
+        }
+    }
+    // 剩余位用 1 填满最后一个字节。
+    void flush() {
+        if (used > 0) put(0x7F, 8 - used);
+    }
+private:
+    std::ostream &out;
+    uint32_t acc = 0;
+    int used = 0;
+};
+
+int magnitudeCategory(int v) {
+    int a = v < 0 ? -v : v;
+    int n = 0;
+    while (a) {
+        ++n;
+        a >>= 1;
+    }
+    return n;
+}
+
+// 幅值位：正数写原码，负数写 (v - 1) 的低 n 位（即反码）。
+void putValue(BitWriter &bw, const Code &code, int v, int category) {
+    bw.put(code.bits, code.length);
+    if (category) bw.put(static_cast<uint32_t>(v < 0 ? v - 1 : v), category);
+}
+
+void putU16(std::ostream &out, uint32_t v) {
+    out.put(static_cast<char>((v >> 8) & 0xFF));
+    out.put(static_cast<char>(v & 0xFF));
+}
+
+void putMarker(std::ostream &out, uint8_t marker) {
+    out.put(static_cast<char>(0xFF));
+    out.put(static_cast<char>(marker));
+}
+
+void writeHuffmanTable(std::ostream &out, uint8_t classAndId, const uint8_t bits[16], const uint8_t *vals) {
+    size_t count = 0;
+    for (int i = 0; i < 16; ++i) count += bits[i];
+    putMarker(out, 0xC4);
+    putU16(out, static_cast<uint32_t>(2 + 1 + 16 + count));
+    out.put(static_cast<char>(classAndId));
+    out.write(reinterpret_cast<const char*>(bits), 16);
+    out.write(reinterpret_cast<const char*>(vals), static_cast<std::streamsize>(count));
+}
+}
+
+void JFIF::writeBaseline(std::ostream &out, uint32_t width, uint32_t height, const uint8_t qtable[64],
+                         const std::vector<DCTCodec::QuantBlock> &blocks) {
+    if (width == 0 || height == 0 || width > 65535 || height > 65535) {
+        throw std::runtime_error("JFIF dimensions must be 1-65535");
+    }
+    size_t blocksX = (width + 7) / 8, blocksY = (height + 7) / 8;
+    if (blocks.size() != blocksX * blocksY) throw std::runtime_error("JFIF block count mismatch");
+
+    putMarker(out, 0xD8); // SOI
+    putMarker(out, 0xE0); // APP0: JFIF 1.01，无单位 1:1 像素比，无缩略图
+    putU16(out, 16);
+    out.write("JFIF\0", 5);
+    out.put(1); out.put(1);
+    out.put(0);
+    putU16(out, 1); putU16(out, 1);
+    out.put(0); out.put(0);
+
+    putMarker(out, 0xDB); // DQT：8 位精度，表 0
+    putU16(out, 2 + 1 + 64);
+    out.put(0);
+    for (int k = 0; k < 64; ++k) out.put(static_cast<char>(qtable[DCTCodec::kZigzag[k]]));
+
+    putMarker(out, 0xC0); // SOF0：基线，8 位，单分量，1x1 采样，量化表 0
+    putU16(out, 2 + 6 + 3);
+    out.put(8);
+    putU16(out, height);
+    putU16(out, width);
+    out.put(1);
+    out.put(1); out.put(0x11); out.put(0);
+
+    writeHuffmanTable(out, 0x00, kDcBits, kDcVals);
+    writeHuffmanTable(out, 0x10, kAcBits, kAcVals);
+
+    putMarker(out, 0xDA); // SOS：分量 1 使用 DC 表 0 / AC 表 0，Ss=0 Se=63 Ah=Al=0
+    putU16(out, 2 + 1 + 2 + 3);
+    out.put(1);
+    out.put(1); out.put(0x00);
+    out.put(0); out.put(63); out.put(0);
+
+    static const std::vector<Code> dcCodes = buildCodes(kDcBits, kDcVals);
+    static const std::vector<Code> acCodes = buildCodes(kAcBits, kAcVals);
+    BitWriter bw(out);
+    int prevDC = 0;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (b % blocksX == 0) Progress::report(b / blocksX, blocksY);
+        const int16_t *c = blocks[b].coeffs;
+        // 基线 8 位：DC 限制在 [-1024, 1023] 使差分类别不超过 11，AC 幅值不超过 1023。
+        int dc = std::max(-1024, std::min(1023, static_cast<int>(c[0])));
+        int diff = dc - prevDC;
+        prevDC = dc;
+        int cat = magnitudeCategory(diff);
+        putValue(bw, dcCodes[cat], diff, cat);
+
+        int run = 0;
+        for (int k = 1; k < 64; ++k) {
+            int v = std::max(-1023, std::min(1023, static_cast<int>(c[DCTCodec::kZigzag[k]])));
+            if (v == 0) {
+                ++run;
+                continue;
+            }
+            while (run >= 16) {
+                bw.put(acCodes[0xF0].bits, acCodes[0xF0].length); // ZRL：16 个零
+                run -= 16;
+            }
+            int acCat = magnitudeCategory(v);
+            putValue(bw, acCodes[(run << 4) | acCat], v, acCat);
+            run = 0;
+        }
+        if (run > 0) bw.put(acCodes[0x00].bits, acCodes[0x00].length); // EOB
+    }
+    bw.flush();
+    putMarker(out, 0xD9); // EOI
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include "DCTCodec.h"
+
+// Baseline sequential JFIF writer for already-quantized 8x8 blocks.
+// 单分量（灰度）、8 位精度，使用 ITU-T T.81 附录 K 的标准亮度哈夫曼表，
+// 因此任何 JPEG 解码器（浏览器、OpenCV imread）都能直接读取。
+namespace JFIF {
+// blocks 为块行优先、块内自然顺序的量化系数，覆盖 ceil(width/8) x ceil(height/8) 个块；
+// qtable 为自然顺序的量化表（1-255），写入 DQT 时转为 zigzag 顺序。
+void writeBaseline(std::ostream &out, uint32_t width, uint32_t height, const uint8_t qtable[64],
+                   const std::vector<DCTCodec::QuantBlock> &blocks);
+}
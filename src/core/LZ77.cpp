@@ -0,0 +1,245 @@
+#include "LZ77.h"
+#include "MemProfile.h"
+#include "MemoryStream.h"
+#include "Progress.h"
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+const int kHashLog = 16;
+const size_t kMinMatch = 4;
+const size_t kMaxOffset = 65535;
+const size_t kLastLiterals = 5;  // 末尾 5 字节总是字面量
+const size_t kMatchLimit = 12;   // 距末尾 12 字节以内不再开始新的匹配
+const size_t kWildSlack = 32;    // 解码缓冲区尾部余量，允许按 8 字节整块复制越过末尾
+const int kSkipTrigger = 6;      // 连续未命中时逐步加大步长，快速跳过不可压缩区域
+
+uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hash4(uint32_t v) {
+    return (v * 2654435761u) >> (32 - kHashLog);
+}
+
+void writeLength(std::vector<uint8_t> &out, size_t len) {
+    while (len >= 255) {
+        out.push_back(255);
+        len -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(len));
+}
+
+void emitSequence(std::vector<uint8_t> &out, const uint8_t *literals, size_t litLen, size_t offset, size_t matchLen) {
+    size_t ml = matchLen ? matchLen - kMinMatch : 0;
+    uint8_t token = static_cast<uint8_t>((std::min<size_t>(litLen, 15) << 4) | std::min<size_t>(ml, 15));
+    out.push_back(token);
+    if (litLen >= 15) writeLength(out, litLen - 15);
+    out.insert(out.end(), literals, literals + litLen);
+    if (!matchLen) return;
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (ml >= 15) writeLength(out, ml - 15);
+}
+
+// 按 Chunk 字节整块复制直到覆盖 [dst, end)，调用方保证两端都有足够余量，
+// 且 src 与 dst 的距离不小于 Chunk。
+template <size_t Chunk>
+void wildCopy(uint8_t *dst, const uint8_t *src, uint8_t *end) {
+    do {
+        std::memcpy(dst, src, Chunk);
+        dst += Chunk;
+        src += Chunk;
+    } while (dst < end);
+}
+
+size_t readLength(const uint8_t *&ip, const uint8_t *iend) {
+    size_t len = 0;
+    uint8_t b;
+    do {
+        if (ip >= iend) throw std::runtime_error("Corrupted LZ77 stream");
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return len;
+}
+}
+
+std::vector<uint8_t> LZ77::encodeChannel(const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> out;
+    out.reserve(data.size() + data.size() / 255 + 16);
+    const uint8_t *base = data.data();
+    size_t n = data.size();
+    size_t anchor = 0;
+    if (n >= kMatchLimit + 1) {
+        std::vector<uint32_t> table(size_t(1) << kHashLog, 0);
+        size_t matchStart = n - kMatchLimit;
+        size_t matchEnd = n - kLastLiterals;
+        size_t pos = 1;
+        table[hash4(read32(base))] = 0;
+        size_t nextReport = 0;
+        while (pos < matchStart) {
+            if (pos >= nextReport) {
+                Progress::report(pos, n);
+                nextReport = pos + Progress::kReportInterval;
+            }
+            // 找候选：每次未命中时步长随未命中次数增长。
+            size_t attempts = size_t(1) << kSkipTrigger;
+            size_t candidate = 0;
+            bool found = false;
+            while (pos < matchStart) {
+                uint32_t seq = read32(base + pos);
+                uint32_t h = hash4(seq);
+                candidate = table[h];
+                table[h] = static_cast<uint32_t>(pos);
+                if (pos - candidate <= kMaxOffset && candidate < pos && read32(base + candidate) == seq) {
+                    found = true;
+                    break;
+                }
+                pos += attempts++ >> kSkipTrigger;
+            }
+            if (!found) break;
+            // 向前扩展到字面量区域，再向后扩展匹配长度。
+            while (pos > anchor && candidate > 0 && base[pos - 1] == base[candidate - 1]) {
+                --pos;
+                --candidate;
+            }
+            size_t len = kMinMatch;
+            while (pos + len < matchEnd && base[pos + len] == base[candidate + len]) ++len;
+            emitSequence(out, base + anchor, pos - anchor, pos - candidate, len);
+            pos += len;
+            anchor = pos;
+            if (pos < matchStart) table[hash4(read32(base + pos - 2))] = static_cast<uint32_t>(pos - 2);
+        }
+    }
+    emitSequence(out, base + anchor, n - anchor, 0, 0);
+    return out;
+}
+
+std::vector<uint8_t> LZ77::decodeChannel(const uint8_t *data, size_t size, size_t rawSize) {
+    // 输入复制到带尾部余量的缓冲区，字面量可以整块读取。
+    std::vector<uint8_t> input(size + kWildSlack);
+    std::memcpy(input.data(), data, size);
+    std::vector<uint8_t> out(rawSize + kWildSlack);
+    const uint8_t *ip = input.data();
+    const uint8_t *iend = ip + size;
+    uint8_t *obegin = out.data();
+    uint8_t *op = obegin;
+    uint8_t *oend = obegin + rawSize;
+    size_t nextReport = 0;
+    while (true) {
+        if (ip >= iend) throw std::runtime_error("Corrupted LZ77 stream");
+        if (static_cast<size_t>(op - obegin) >= nextReport) {
+            Progress::report(op - obegin, rawSize);
+            nextReport = (op - obegin) + Progress::kReportInterval;
+        }
+        uint8_t token = *ip++;
+        size_t litLen = token >> 4;
+        if (litLen == 15) litLen += readLength(ip, iend);
+        if (litLen > static_cast<size_t>(iend - ip) || litLen > static_cast<size_t>(oend - op)) {
+            throw std::runtime_error("Corrupted LZ77 stream");
+        }
+        if (litLen) wildCopy<16>(op, ip, op + litLen);
+        op += litLen;
+        ip += litLen;
+        if (ip == iend) break; // 最后一个序列只有字面量
+
+        if (iend - ip < 2) throw std::runtime_error("Corrupted LZ77 stream");
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        size_t matchLen = (token & 15);
+        if (matchLen == 15) matchLen += readLength(ip, iend);
+        matchLen += kMinMatch;
+        if (offset == 0 || offset > static_cast<size_t>(op - obegin) || matchLen > static_cast<size_t>(oend - op)) {
+            throw std::runtime_error("Corrupted LZ77 stream");
+        }
+        const uint8_t *match = op - offset;
+        if (offset >= 16) {
+            wildCopy<16>(op, match, op + matchLen);
+        } else if (offset >= 8) {
+            wildCopy<8>(op, match, op + matchLen);
+        } else {
+            // 短距离重叠（如连续相同像素）：先逐字节展开一个不小于 8 字节的整周期，
+            // 之后以该周期为距离整块复制。
+            size_t period = offset * ((8 + offset - 1) / offset);
+            size_t head = std::min(period, matchLen);
+            for (size_t i = 0; i < head; ++i) op[i] = match[i];
+            if (matchLen > head) wildCopy<8>(op + head, op + head - period, op + matchLen);
+        }
+        op += matchLen;
+    }
+    if (op != oend) throw std::runtime_error("LZ77 size mismatch");
+    out.resize(rawSize);
+    return out;
+}
+
+void LZ77::compress(const cv::Mat &img, const std::string &outputPath) {
+    std::vector<uint8_t> buffer;
+    compress(img, buffer);
+    ImageIO::writeFile(outputPath, buffer);
+}
+
+void LZ77::compress(const cv::Mat &img, std::vector<uint8_t> &out) {
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    compress(img, os);
+}
+
+void LZ77::compress(const cv::Mat &img, std::ostream &ofs) {
+    MemProfile::Scope memScope("lz77");
+    ImageData data = ImageIO::fromMat(img, ColorTransform::current());
+    ofs.write("LZ77", 4);
+    ofs.write(reinterpret_cast<const char*>(&data.width), sizeof(uint32_t));
+    ofs.write(reinterpret_cast<const char*>(&data.height), sizeof(uint32_t));
+    ofs.put(static_cast<char>(data.channels));
+    ofs.put(0); ofs.put(static_cast<char>(data.transform)); ofs.put(0);
+    for (size_t c = 0; c < data.channelData.size(); ++c) {
+        Progress::Section section(c, data.channelData.size());
+        auto encoded = encodeChannel(data.channelData[c]);
+        uint32_t sz = static_cast<uint32_t>(encoded.size());
+        ofs.write(reinterpret_cast<const char*>(&sz), sizeof(uint32_t));
+        ofs.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+    }
+}
+
+cv::Mat LZ77::decompress(const std::string &inputPath) {
+    std::vector<uint8_t> buffer = ImageIO::readFile(inputPath);
+    return decompress(buffer.data(), buffer.size());
+}
+
+cv::Mat LZ77::decompress(const uint8_t *data, size_t size) {
+    SpanStreamBuf buf(data, size);
+    std::istream is(&buf);
+    return decompress(is);
+}
+
+cv::Mat LZ77::decompress(std::istream &ifs) {
+    MemProfile::Scope memScope("lz77");
+    char magic[4];
+    ifs.read(magic, 4);
+    if (std::string(magic, 4) != "LZ77") throw std::runtime_error("Invalid magic for LZ77");
+    ImageData data;
+    ifs.read(reinterpret_cast<char*>(&data.width), sizeof(uint32_t));
+    ifs.read(reinterpret_cast<char*>(&data.height), sizeof(uint32_t));
+    ifs.read(reinterpret_cast<char*>(&data.channels), 1);
+    char pad[3]; ifs.read(pad, 3);
+    if (!ColorTransform::isKnown(static_cast<uint8_t>(pad[1]))) throw std::runtime_error("Unsupported LZ77 colour transform");
+    data.transform = static_cast<ColorTransform::Kind>(pad[1]);
+    data.channelData.resize(data.channels);
+    for (size_t c = 0; c < data.channelData.size(); ++c) {
+        Progress::Section section(c, data.channelData.size());
+        uint32_t sz = 0;
+        ifs.read(reinterpret_cast<char*>(&sz), sizeof(uint32_t));
+        std::vector<uint8_t> enc(sz);
+        ifs.read(reinterpret_cast<char*>(enc.data()), sz);
+        if (!ifs) throw std::runtime_error("Truncated LZ77 data");
+        data.channelData[c] = decodeChannel(enc.data(), enc.size(), static_cast<size_t>(data.width) * data.height);
+    }
+    return ImageIO::toMat(data);
+}
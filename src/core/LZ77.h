@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <iosfwd>
+#include "ImageData.h"
+
+// LZ4-style byte-oriented LZ77: hash-table match finding over a 64 KB window,
+// token/literal/offset sequences without bit I/O, and wild-copy decoding.
+// 面向解码速度，压缩率低于 Huffman/LZW。
+namespace LZ77 {
+std::vector<uint8_t> encodeChannel(const std::vector<uint8_t> &data);
+// rawSize 为原始数据长度；编码数据损坏时抛出异常，不会越界读写。
+std::vector<uint8_t> decodeChannel(const uint8_t *data, size_t size, size_t rawSize);
+void compress(const cv::Mat &img, const std::string &outputPath);
+void compress(const cv::Mat &img, std::ostream &out);
+void compress(const cv::Mat &img, std::vector<uint8_t> &out);
+cv::Mat decompress(const std::string &inputPath);
+cv::Mat decompress(std::istream &in);
+cv::Mat decompress(const uint8_t *data, size_t size);
+}
@@ -1,6 +1,10 @@
 #include "LZW.h"
+#include "MemProfile.h"
+#include "MemoryStream.h"
+#include "Progress.h"
 #include <unordered_map>
-#include <fstream>
+#include <istream>
+#include <ostream>
 #include <stdexcept>
 #include <sstream>
 #include "BitIO.h"
@@ -15,7 +19,9 @@ std::vector<uint16_t> LZW::encodeChannel(const std::vector<uint8_t> &data) {
     const uint16_t dictMax = 4095;
     std::string w;
     std::vector<uint16_t> codes;
-    for (uint8_t c : data) {
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (i % Progress::kReportInterval == 0) Progress::report(i, data.size());
+        uint8_t c = data[i];
         std::string wc = w + static_cast<char>(c);
         if (dict.count(wc)) {
             w = wc;
@@ -39,6 +45,7 @@ std::vector<uint8_t> LZW::decodeChannel(const std::vector<uint16_t> &codes) {
     std::string w(1, static_cast<char>(codes[0]));
     std::vector<uint8_t> out(w.begin(), w.end());
     for (size_t i = 1; i < codes.size(); ++i) {
+        if (i % Progress::kReportInterval == 0) Progress::report(i, codes.size());
         uint16_t k = codes[i];
         std::string entry;
         if (k < dictSize) {
@@ -58,16 +65,29 @@ std::vector<uint8_t> LZW::decodeChannel(const std::vector<uint16_t> &codes) {
 }
 
 void LZW::compress(const cv::Mat &img, const std::string &outputPath) {
-    ImageData data = ImageIO::fromMat(img);
-    std::ofstream ofs(outputPath, std::ios::binary);
-    if (!ofs) throw std::runtime_error("Cannot open output file");
+    std::vector<uint8_t> buffer;
+    compress(img, buffer);
+    ImageIO::writeFile(outputPath, buffer);
+}
+
+void LZW::compress(const cv::Mat &img, std::vector<uint8_t> &out) {
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    compress(img, os);
+}
+
+void LZW::compress(const cv::Mat &img, std::ostream &ofs) {
+    MemProfile::Scope memScope("lzw");
+    ImageData data = ImageIO::fromMat(img, ColorTransform::current());
     ofs.write("LZW ", 4);
     ofs.write(reinterpret_cast<const char*>(&data.width), sizeof(uint32_t));
     ofs.write(reinterpret_cast<const char*>(&data.height), sizeof(uint32_t));
     ofs.put(static_cast<char>(data.channels));
-    ofs.put(0); ofs.put(0); ofs.put(0);
-    for (const auto &ch : data.channelData) {
-        auto codes = encodeChannel(ch);
+    ofs.put(0); ofs.put(static_cast<char>(data.transform)); ofs.put(0);
+    for (size_t c = 0; c < data.channelData.size(); ++c) {
+        Progress::Section section(c, data.channelData.size());
+        auto codes = encodeChannel(data.channelData[c]);
         uint64_t validBits = static_cast<uint64_t>(codes.size()) * 12; // each code is 12 bits
 
         std::stringstream ss;
@@ -87,8 +107,18 @@ void LZW::compress(const cv::Mat &img, const std::string &outputPath) {
 }
 
 cv::Mat LZW::decompress(const std::string &inputPath) {
-    std::ifstream ifs(inputPath, std::ios::binary);
-    if (!ifs) throw std::runtime_error("Cannot open input file");
+    std::vector<uint8_t> buffer = ImageIO::readFile(inputPath);
+    return decompress(buffer.data(), buffer.size());
+}
+
+cv::Mat LZW::decompress(const uint8_t *data, size_t size) {
+    SpanStreamBuf buf(data, size);
+    std::istream is(&buf);
+    return decompress(is);
+}
+
+cv::Mat LZW::decompress(std::istream &ifs) {
+    MemProfile::Scope memScope("lzw");
     char magic[4]; ifs.read(magic, 4);
     if (std::string(magic,4) != "LZW ") throw std::runtime_error("Invalid magic for LZW");
     ImageData data;
@@ -96,8 +126,12 @@ cv::Mat LZW::decompress(const std::string &inputPath) {
     ifs.read(reinterpret_cast<char*>(&data.height), sizeof(uint32_t));
     ifs.read(reinterpret_cast<char*>(&data.channels), 1);
     char pad[3]; ifs.read(pad,3);
+    if (!ColorTransform::isKnown(static_cast<uint8_t>(pad[1]))) throw std::runtime_error("Unsupported LZW colour transform");
+    data.transform = static_cast<ColorTransform::Kind>(pad[1]);
     data.channelData.resize(data.channels);
-    for (auto &ch : data.channelData) {
+    for (size_t c = 0; c < data.channelData.size(); ++c) {
+        Progress::Section section(c, data.channelData.size());
+        auto &ch = data.channelData[c];
         uint64_t validBits = 0; uint32_t byteSize = 0;
         ifs.read(reinterpret_cast<char*>(&validBits), sizeof(uint64_t));
         ifs.read(reinterpret_cast<char*>(&byteSize), sizeof(uint32_t));
@@ -0,0 +1,246 @@
+#include "MemProfile.h"
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#ifndef IMG_MEM_PROFILE
+bool MemProfile::enabled() {
+    return false;
+}
+
+MemProfile::Report MemProfile::report() {
+    return Report();
+}
+
+int MemProfile::currentStage() {
+    return 0;
+}
+#else
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+
+namespace {
+// 计数器是固定大小的静态数组：operator new 中不能再分配内存，也不依赖动态初始化顺序。
+const int kMaxStages = 64;
+
+struct Counters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> live{0};
+    std::atomic<uint64_t> peak{0};
+};
+
+Counters counters[kMaxStages];
+const char *names[kMaxStages] = {"(unscoped)"};
+std::atomic<int> stageCount{1};
+std::atomic<uint64_t> totalLive{0};
+std::atomic<uint64_t> totalPeak{0};
+thread_local int activeStage = 0;
+
+void raise(std::atomic<uint64_t> &peak, uint64_t value) {
+    uint64_t seen = peak.load(std::memory_order_relaxed);
+    while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+int stageId(const char *name) {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    int count = stageCount.load();
+    for (int i = 0; i < count; ++i) {
+        if (names[i] == name || std::strcmp(names[i], name) == 0) return i;
+    }
+    if (count == kMaxStages) return 0; // 超出上限的 Scope 计入 "(unscoped)"
+    names[count] = name;
+    stageCount = count + 1;
+    return count;
+}
+
+void recordAlloc(int stage, uint64_t size) {
+    Counters &c = counters[stage];
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(size, std::memory_order_relaxed);
+    raise(c.peak, c.live.fetch_add(size, std::memory_order_relaxed) + size);
+    raise(totalPeak, totalLive.fetch_add(size, std::memory_order_relaxed) + size);
+}
+
+void recordFree(int stage, uint64_t size) {
+    counters[stage].live.fetch_sub(size, std::memory_order_relaxed);
+    totalLive.fetch_sub(size, std::memory_order_relaxed);
+}
+
+// 每块前置 16 字节记录大小与所属 Scope，保持 malloc 的对齐。
+struct alignas(16) BlockHeader {
+    uint64_t size;
+    int32_t stage;
+};
+static_assert(sizeof(BlockHeader) == 16, "header must preserve malloc alignment");
+
+void *trackedAlloc(std::size_t size) noexcept {
+    auto *header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+    if (!header) return nullptr;
+    header->size = size;
+    header->stage = activeStage;
+    recordAlloc(header->stage, size);
+    return header + 1;
+}
+
+void trackedFree(void *ptr) noexcept {
+    if (!ptr) return;
+    BlockHeader *header = static_cast<BlockHeader*>(ptr) - 1;
+    recordFree(header->stage, header->size);
+    std::free(header);
+}
+
+#if CV_VERSION_MAJOR >= 4
+// 包装 OpenCV 默认分配器：cv::Mat 的像素缓冲区走 cv::fastMalloc，不经过 operator new。
+class CountingMatAllocator : public cv::MatAllocator {
+public:
+    explicit CountingMatAllocator(cv::MatAllocator *inner) : base(inner) {}
+
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        cv::UMatData *u = base->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        if (u && !data) track(u);
+        return u;
+    }
+    bool allocate(cv::UMatData *u, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override {
+        return base->allocate(u, accessFlags, usageFlags);
+    }
+    void deallocate(cv::UMatData *u) const override {
+        if (u) untrack(u);
+        base->deallocate(u);
+    }
+
+private:
+    void track(cv::UMatData *u) const {
+        int stage = activeStage;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            owners[u] = stage;
+        }
+        recordAlloc(stage, u->size);
+    }
+    void untrack(cv::UMatData *u) const {
+        int stage = -1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = owners.find(u);
+            if (it == owners.end()) return;
+            stage = it->second;
+            owners.erase(it);
+        }
+        recordFree(stage, u->size);
+    }
+
+    cv::MatAllocator *base;
+    mutable std::mutex mutex;
+    mutable std::unordered_map<cv::UMatData*, int> owners;
+};
+
+// 静态初始化时安装；分配器对象故意不释放，保证进程退出前析构的 Mat 仍能正确归还。
+const bool matAllocatorInstalled = [] {
+    cv::Mat::setDefaultAllocator(new CountingMatAllocator(cv::Mat::getStdAllocator()));
+    return true;
+}();
+#endif
+}
+
+void *operator new(std::size_t size) {
+    void *p = trackedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](std::size_t size) {
+    void *p = trackedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return trackedAlloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return trackedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    trackedFree(ptr);
+}
+
+MemProfile::Scope::Scope(const char *name) : previous(activeStage) {
+    activeStage = stageId(name);
+}
+
+MemProfile::Scope::~Scope() {
+    activeStage = previous;
+}
+
+int MemProfile::currentStage() {
+    return activeStage;
+}
+
+MemProfile::Adopt::Adopt(int stage) : previous(activeStage) {
+    activeStage = stage;
+}
+
+MemProfile::Adopt::~Adopt() {
+    activeStage = previous;
+}
+
+bool MemProfile::enabled() {
+    return true;
+}
+
+MemProfile::Report MemProfile::report() {
+    Report r;
+    int count = stageCount.load();
+    for (int i = 0; i < count; ++i) {
+        StageStats s;
+        s.name = names[i];
+        s.allocations = counters[i].allocations;
+        s.bytes = counters[i].bytes;
+        s.peakLive = counters[i].peak;
+        s.live = counters[i].live;
+        r.stages.push_back(s);
+    }
+    r.peakLive = totalPeak;
+#ifndef _WIN32
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        r.maxRssBytes = static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        r.maxRssBytes = static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    return r;
+}
+#endif
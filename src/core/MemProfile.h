@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Allocation profiling by named scope (pipeline stage or codec).
+// 仅在以 IMG_COMPRESS_MEM_PROFILE=ON 构建时生效（定义 IMG_MEM_PROFILE）：替换全局 operator new/delete，
+// 并在 OpenCV 4 下包装 cv::Mat 的默认分配器。分配计入分配发生时当前线程最内层的 Scope，
+// 释放从同一 Scope 的存活字节中扣除；未启用时 Scope 为空操作，没有运行时开销。
+namespace MemProfile {
+struct StageStats {
+    std::string name;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;     // 累计分配字节
+    uint64_t peakLive = 0;  // 该 Scope 名下同时存活字节的峰值
+    uint64_t live = 0;      // 报告时仍存活的字节
+};
+
+struct Report {
+    std::vector<StageStats> stages; // 第一项为 "(unscoped)"
+    uint64_t peakLive = 0;          // 进程内同时存活的跟踪字节峰值
+    uint64_t maxRssBytes = 0;       // 操作系统报告的常驻内存峰值（不可用时为 0）
+};
+
+bool enabled();
+Report report();
+// 当前线程最内层 Scope 的编号，配合 Adopt 把 Scope 带到工作线程上（Parallel::forEach 使用）。
+int currentStage();
+
+#ifdef IMG_MEM_PROFILE
+// name 必须是静态存储期的字符串（通常为字面量）；同名 Scope 共享一组计数。
+class Scope {
+public:
+    explicit Scope(const char *name);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+private:
+    int previous;
+};
+
+// 在工作线程上安装调用线程取得的 Scope 编号，析构时恢复。
+class Adopt {
+public:
+    explicit Adopt(int stage);
+    ~Adopt();
+    Adopt(const Adopt &) = delete;
+    Adopt &operator=(const Adopt &) = delete;
+private:
+    int previous;
+};
+#else
+class Scope {
+public:
+    explicit Scope(const char *) {}
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+};
+
+class Adopt {
+public:
+    explicit Adopt(int) {}
+    Adopt(const Adopt &) = delete;
+    Adopt &operator=(const Adopt &) = delete;
+};
+#endif
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <streambuf>
+#include <vector>
+
+// std::streambuf adapters over memory buffers so the stream-based codecs
+// can read/write caller-owned bytes without temporary files or copies.
+// 读端直接引用调用方内存，写端直接追加到调用方的 vector。
+
+class SpanStreamBuf : public std::streambuf {
+public:
+    SpanStreamBuf(const uint8_t *data, size_t size) {
+        char *begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+        off_type base = dir == std::ios_base::beg ? 0 : dir == std::ios_base::cur ? gptr() - eback() : egptr() - eback();
+        return seekpos(pos_type(base + off), which);
+    }
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        off_type p = off_type(pos);
+        if (!(which & std::ios_base::in) || p < 0 || p > egptr() - eback()) return pos_type(off_type(-1));
+        setg(eback(), eback() + p, egptr());
+        return pos;
+    }
+};
+
+class VectorStreamBuf : public std::streambuf {
+public:
+    explicit VectorStreamBuf(std::vector<uint8_t> &target) : out(target) {}
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (ch != traits_type::eof()) out.push_back(static_cast<uint8_t>(ch));
+        return traits_type::not_eof(ch);
+    }
+    std::streamsize xsputn(const char *s, std::streamsize n) override {
+        out.insert(out.end(), reinterpret_cast<const uint8_t*>(s), reinterpret_cast<const uint8_t*>(s) + n);
+        return n;
+    }
+
+private:
+    std::vector<uint8_t> &out;
+};
@@ -0,0 +1,96 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+void checkPair(const cv::Mat &a, const cv::Mat &b) {
+    if (a.rows != b.rows || a.cols != b.cols || a.type() != b.type()) {
+        throw std::runtime_error("Metrics require images of identical size and type");
+    }
+    if (a.depth() != CV_8U) throw std::runtime_error("Metrics require 8-bit images");
+}
+
+// 单行平方误差和；分段的无分支整数循环可被自动向量化，uint32 段内累加不会溢出。
+uint64_t rowSquaredError(const uint8_t *pa, const uint8_t *pb, int n) {
+    const int chunk = 4096;
+    uint64_t total = 0;
+    for (int start = 0; start < n; start += chunk) {
+        int end = std::min(n, start + chunk);
+        uint32_t acc = 0;
+        for (int i = start; i < end; ++i) {
+            int d = static_cast<int>(pa[i]) - static_cast<int>(pb[i]);
+            acc += static_cast<uint32_t>(d * d);
+        }
+        total += acc;
+    }
+    return total;
+}
+
+struct WindowSums {
+    uint32_t sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+};
+
+// 累加一个 8 像素宽窗口行的统计量，stride 为通道间隔。
+inline void accumulateRow(const uint8_t *pa, const uint8_t *pb, int stride, WindowSums &s) {
+    for (int i = 0; i < 8; ++i) {
+        uint32_t x = pa[i * stride];
+        uint32_t y = pb[i * stride];
+        s.sa += x;
+        s.sb += y;
+        s.saa += x * x;
+        s.sbb += y * y;
+        s.sab += x * y;
+    }
+}
+}
+
+double Metrics::mse(const cv::Mat &a, const cv::Mat &b) {
+    checkPair(a, b);
+    const int n = a.cols * a.channels();
+    uint64_t total = 0;
+    for (int r = 0; r < a.rows; ++r) {
+        total += rowSquaredError(a.ptr<uint8_t>(r), b.ptr<uint8_t>(r), n);
+    }
+    double count = static_cast<double>(a.total()) * a.channels();
+    return count > 0 ? static_cast<double>(total) / count : 0.0;
+}
+
+double Metrics::psnr(const cv::Mat &a, const cv::Mat &b) {
+    double m = mse(a, b);
+    if (m <= 0.0) return std::numeric_limits<double>::infinity();
+    return 10.0 * std::log10(255.0 * 255.0 / m);
+}
+
+double Metrics::ssim(const cv::Mat &a, const cv::Mat &b) {
+    checkPair(a, b);
+    const double c1 = (0.01 * 255) * (0.01 * 255);
+    const double c2 = (0.03 * 255) * (0.03 * 255);
+    const int win = 8, step = 4;
+    const int cn = a.channels();
+    if (a.rows < win || a.cols < win) {
+        // 图像小于窗口时退化为基于 MSE 的判断。
+        return mse(a, b) == 0.0 ? 1.0 : 0.0;
+    }
+    double total = 0.0;
+    uint64_t windows = 0;
+    for (int y = 0; y + win <= a.rows; y += step) {
+        for (int x = 0; x + win <= a.cols; x += step) {
+            for (int c = 0; c < cn; ++c) {
+                WindowSums s;
+                for (int r = 0; r < win; ++r) {
+                    accumulateRow(a.ptr<uint8_t>(y + r) + x * cn + c, b.ptr<uint8_t>(y + r) + x * cn + c, cn, s);
+                }
+                const double n = win * win;
+                double ma = s.sa / n, mb = s.sb / n;
+                double va = s.saa / n - ma * ma;
+                double vb = s.sbb / n - mb * mb;
+                double cov = s.sab / n - ma * mb;
+                total += ((2 * ma * mb + c1) * (2 * cov + c2)) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+                ++windows;
+            }
+        }
+    }
+    return windows ? total / windows : 1.0;
+}
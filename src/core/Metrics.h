@@ -0,0 +1,12 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+
+// Image quality metrics for 8-bit images (1 or 3 channels, same size).
+// 内层循环按行连续访问并使用整数累加，便于编译器自动向量化。
+namespace Metrics {
+double mse(const cv::Mat &a, const cv::Mat &b);
+// 完全相同时返回 +inf。
+double psnr(const cv::Mat &a, const cv::Mat &b);
+// 8x8 窗口、步长 4 的均值 SSIM，多通道取平均。
+double ssim(const cv::Mat &a, const cv::Mat &b);
+}
@@ -0,0 +1,187 @@
+#include "Palette.h"
+#include "Compressor.h"
+#include "Decompressor.h"
+#include "MemProfile.h"
+#include "MemoryStream.h"
+#include "Progress.h"
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+void checkLossless(const std::string &algoName) {
+    if (!Compressor::isLossless(algoName)) {
+        throw std::runtime_error("Palette coding requires a lossless codec (huffman, rle, lzw or lz77)");
+    }
+}
+
+uint32_t pixelKey(const uint8_t *p, int cn) {
+    return cn == 3 ? (p[0] | (p[1] << 8) | (p[2] << 16)) : p[0];
+}
+
+struct Header {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t channels = 0;
+    uint8_t bits = 0;
+    uint16_t colors = 0;
+};
+
+size_t packedRowBytes(uint32_t width, int bits) {
+    return (static_cast<size_t>(width) * bits + 7) / 8;
+}
+}
+
+bool Palette::collectColors(const cv::Mat &img, size_t maxColors, std::vector<uint32_t> &colors) {
+    if (img.depth() != CV_8U || (img.channels() != 1 && img.channels() != 3)) return false;
+    int cn = img.channels();
+    // 连续相同像素很常见（截图、示意图），先与上一个像素比较，命中时跳过哈希查找。
+    std::unordered_set<uint32_t> seen;
+    seen.reserve(maxColors * 2);
+    for (int y = 0; y < img.rows; ++y) {
+        if (y % 64 == 0) Progress::report(y, img.rows);
+        const uint8_t *row = img.ptr<uint8_t>(y);
+        uint32_t last = 0xFFFFFFFFu;
+        for (int x = 0; x < img.cols; ++x) {
+            uint32_t key = pixelKey(row + x * cn, cn);
+            if (key == last) continue;
+            last = key;
+            if (seen.insert(key).second && seen.size() > maxColors) return false;
+        }
+    }
+    colors.assign(seen.begin(), seen.end());
+    std::sort(colors.begin(), colors.end());
+    return true;
+}
+
+int Palette::indexBits(size_t colorCount) {
+    if (colorCount <= 2) return 1;
+    if (colorCount <= 4) return 2;
+    if (colorCount <= 16) return 4;
+    return 8;
+}
+
+bool Palette::isPalette(const uint8_t *data, size_t size) {
+    return size >= 4 && std::memcmp(data, "PAL ", 4) == 0;
+}
+
+bool Palette::compress(const std::string &algoName, const cv::Mat &img, std::vector<uint8_t> &out, size_t maxColors) {
+    MemProfile::Scope memScope("palette");
+    checkLossless(algoName);
+    if (maxColors < 1 || maxColors > kMaxColors) throw std::runtime_error("Palette size must be 1-256");
+    std::vector<uint32_t> colors;
+    {
+        Progress::Section section(0, 2);
+        if (!collectColors(img, maxColors, colors)) return false;
+    }
+    int cn = img.channels();
+    int bits = indexBits(colors.size());
+    std::unordered_map<uint32_t, uint8_t> index;
+    index.reserve(colors.size() * 2);
+    for (size_t i = 0; i < colors.size(); ++i) index[colors[i]] = static_cast<uint8_t>(i);
+
+    // 索引按行打包，高位在前；保持二维布局，编解码器仍能利用行间相关性。
+    size_t rowBytes = packedRowBytes(static_cast<uint32_t>(img.cols), bits);
+    cv::Mat indices = cv::Mat::zeros(img.rows, static_cast<int>(std::max<size_t>(rowBytes, 1)), CV_8UC1);
+    int perByte = 8 / bits;
+    for (int y = 0; y < img.rows; ++y) {
+        const uint8_t *row = img.ptr<uint8_t>(y);
+        uint8_t *dst = indices.ptr<uint8_t>(y);
+        uint32_t lastKey = 0xFFFFFFFFu;
+        uint8_t lastIndex = 0;
+        for (int x = 0; x < img.cols; ++x) {
+            uint32_t key = pixelKey(row + x * cn, cn);
+            if (key != lastKey) {
+                lastKey = key;
+                lastIndex = index[key];
+            }
+            int shift = 8 - bits * (x % perByte + 1);
+            dst[x / perByte] |= static_cast<uint8_t>(lastIndex << shift);
+        }
+    }
+
+    std::vector<uint8_t> encoded;
+    {
+        Progress::Section section(1, 2);
+        Compressor::compressImage(algoName, indices, encoded);
+    }
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    Header h;
+    h.width = static_cast<uint32_t>(img.cols);
+    h.height = static_cast<uint32_t>(img.rows);
+    h.channels = static_cast<uint8_t>(cn);
+    h.bits = static_cast<uint8_t>(bits);
+    h.colors = static_cast<uint16_t>(colors.size());
+    os.write("PAL ", 4);
+    os.write(reinterpret_cast<const char*>(&h.width), sizeof(uint32_t));
+    os.write(reinterpret_cast<const char*>(&h.height), sizeof(uint32_t));
+    os.put(static_cast<char>(h.channels));
+    os.put(static_cast<char>(h.bits));
+    os.write(reinterpret_cast<const char*>(&h.colors), sizeof(uint16_t));
+    for (uint32_t color : colors) {
+        for (int c = 0; c < cn; ++c) os.put(static_cast<char>((color >> (8 * c)) & 0xFF));
+    }
+    uint64_t size = encoded.size();
+    os.write(reinterpret_cast<const char*>(&size), sizeof(uint64_t));
+    os.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    return true;
+}
+
+cv::Mat Palette::decompress(const std::string &algoName, const uint8_t *data, size_t size) {
+    MemProfile::Scope memScope("palette");
+    SpanStreamBuf buf(data, size);
+    std::istream is(&buf);
+    char magic[4];
+    is.read(magic, 4);
+    if (!is || std::string(magic, 4) != "PAL ") throw std::runtime_error("Invalid magic for palette");
+    Header h;
+    is.read(reinterpret_cast<char*>(&h.width), sizeof(uint32_t));
+    is.read(reinterpret_cast<char*>(&h.height), sizeof(uint32_t));
+    h.channels = static_cast<uint8_t>(is.get());
+    h.bits = static_cast<uint8_t>(is.get());
+    is.read(reinterpret_cast<char*>(&h.colors), sizeof(uint16_t));
+    if (!is || (h.channels != 1 && h.channels != 3) || h.colors == 0 || h.colors > kMaxColors ||
+        h.bits != indexBits(h.colors)) {
+        throw std::runtime_error("Invalid palette header");
+    }
+    std::vector<uint8_t> palette(static_cast<size_t>(h.colors) * h.channels);
+    is.read(reinterpret_cast<char*>(palette.data()), static_cast<std::streamsize>(palette.size()));
+    uint64_t layerSize = 0;
+    is.read(reinterpret_cast<char*>(&layerSize), sizeof(uint64_t));
+    size_t offset = 16 + palette.size() + sizeof(uint64_t);
+    if (!is || size - offset < layerSize) throw std::runtime_error("Truncated palette data");
+
+    cv::Mat indices;
+    {
+        Progress::Section section(0, 2);
+        indices = Decompressor::decompressImage(algoName, data + offset, static_cast<size_t>(layerSize));
+    }
+    size_t rowBytes = packedRowBytes(h.width, h.bits);
+    if (indices.channels() != 1 || static_cast<uint32_t>(indices.rows) != h.height ||
+        static_cast<size_t>(indices.cols) != std::max<size_t>(rowBytes, 1)) {
+        throw std::runtime_error("Palette index plane size mismatch");
+    }
+
+    Progress::Section section(1, 2);
+    cv::Mat img(static_cast<int>(h.height), static_cast<int>(h.width), h.channels == 3 ? CV_8UC3 : CV_8UC1);
+    int perByte = 8 / h.bits;
+    uint8_t mask = static_cast<uint8_t>((1u << h.bits) - 1);
+    for (int y = 0; y < img.rows; ++y) {
+        if (y % 64 == 0) Progress::report(y, img.rows);
+        const uint8_t *src = indices.ptr<uint8_t>(y);
+        uint8_t *dst = img.ptr<uint8_t>(y);
+        for (int x = 0; x < img.cols; ++x) {
+            int shift = 8 - h.bits * (x % perByte + 1);
+            uint8_t idx = static_cast<uint8_t>((src[x / perByte] >> shift) & mask);
+            if (idx >= h.colors) throw std::runtime_error("Palette index out of range");
+            std::memcpy(dst + x * h.channels, &palette[static_cast<size_t>(idx) * h.channels], h.channels);
+        }
+    }
+    return img;
+}
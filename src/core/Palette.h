@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Palette pre-stage ("PAL ") for the lossless codecs.
+// 颜色数不超过阈值时，文件存调色板和单个索引平面（按颜色数打包为每像素 1/2/4/8 位，
+// 每行按字节对齐），索引平面再交给所选编解码器编码，代替逐通道编码三个完整平面。
+namespace Palette {
+const size_t kMaxColors = 256;
+
+// 统计不同颜色（BGR 三元组或灰度值），超过 maxColors 时立即停止并返回 false。
+// 成功时 colors 为按数值排序的调色板，每项按 B | G<<8 | R<<16 打包。
+bool collectColors(const cv::Mat &img, size_t maxColors, std::vector<uint32_t> &colors);
+// 颜色数对应的索引位宽：1、2、4 或 8。
+int indexBits(size_t colorCount);
+// 颜色数超过 maxColors（1-256）时返回 false 且不写 out，由调用方改用普通编码。仅支持无损算法。
+bool compress(const std::string &algoName, const cv::Mat &img, std::vector<uint8_t> &out, size_t maxColors = kMaxColors);
+cv::Mat decompress(const std::string &algoName, const uint8_t *data, size_t size);
+bool isPalette(const uint8_t *data, size_t size);
+}
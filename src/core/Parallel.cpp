@@ -0,0 +1,159 @@
+#include "Parallel.h"
+#include "MemProfile.h"
+#include "Progress.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+std::atomic<size_t> configuredThreads{0};
+thread_local bool onPoolThread = false;
+
+// 进程内共享的辅助线程池，按需增长到 maxThreads() - 1 个线程后复用。
+// 批处理、常驻服务、GUI 线程池里的多个调用方同时 forEach 时共用这些线程，
+// 而不是每次调用各自创建 hardware_concurrency 个线程。
+class SharedPool {
+public:
+    static SharedPool &instance() {
+        static SharedPool pool;
+        return pool;
+    }
+
+    void submit(std::function<void()> job, size_t wanted) {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (threads.size() < wanted) threads.emplace_back([this] { loop(); });
+        jobs.push_back(std::move(job));
+        cv.notify_one();
+    }
+
+    ~SharedPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shutdown = true;
+        }
+        cv.notify_all();
+        for (auto &t : threads) t.join();
+    }
+
+private:
+    SharedPool() = default;
+
+    void loop() {
+        onPoolThread = true;
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return shutdown || !jobs.empty(); });
+                if (jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> threads;
+    bool shutdown = false;
+};
+
+// 一次 forEach 的共享状态。辅助任务可能在调用方返回后才出队，因此用 shared_ptr 持有；
+// fn 只有在成功领取到序号后才会被调用，而调用方会等所有已领取的序号执行完再返回。
+struct Batch {
+    const std::function<void(size_t)> *fn = nullptr;
+    size_t count = 0;
+    int memStage = 0; // 调用线程的 MemProfile Scope，池线程上的分配计入同一 Scope
+    std::atomic<size_t> next{0};
+    std::atomic<bool> stop{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t finished = 0;
+    std::exception_ptr error;
+};
+
+// 领取并执行序号，直到领完或出错；caller 为 true 时顺带报告进度（监听器是线程局部的）。
+void work(Batch &b, bool caller) {
+    while (!b.stop) {
+        size_t i = b.next++;
+        if (i >= b.count) break;
+        std::exception_ptr failure;
+        try {
+            (*b.fn)(i);
+        } catch (...) {
+            failure = std::current_exception();
+        }
+        size_t finished;
+        {
+            std::lock_guard<std::mutex> lock(b.mutex);
+            if (failure && !b.error) b.error = failure;
+            finished = ++b.finished;
+        }
+        b.cv.notify_all();
+        if (failure) {
+            b.stop = true;
+            break;
+        }
+        if (caller) {
+            try {
+                Progress::report(finished, b.count);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(b.mutex);
+                if (!b.error) b.error = std::current_exception();
+                b.stop = true;
+                break;
+            }
+        }
+    }
+}
+}
+
+void Parallel::setMaxThreads(size_t threads) {
+    configuredThreads = threads;
+}
+
+size_t Parallel::maxThreads() {
+    size_t n = configuredThreads;
+    if (n == 0) n = std::thread::hardware_concurrency();
+    return std::max<size_t>(1, n);
+}
+
+void Parallel::forEach(size_t count, const std::function<void(size_t)> &fn) {
+    if (count == 0) return;
+    size_t threads = std::min(count, maxThreads());
+    // 池线程上的嵌套调用直接串行执行，避免池线程互相等待。
+    if (threads == 1 || onPoolThread) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+            Progress::report(i + 1, count);
+        }
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->fn = &fn;
+    batch->count = count;
+    batch->memStage = MemProfile::currentStage();
+    for (size_t t = 1; t < threads; ++t) {
+        SharedPool::instance().submit([batch] {
+            MemProfile::Adopt memScope(batch->memStage);
+            work(*batch, false);
+        }, maxThreads() - 1);
+    }
+    // 调用线程本身也领取序号，即使池线程都在忙也能独立完成全部工作。
+    work(*batch, true);
+
+    // 关闭领取：此后的 next++ 都会越过 count。等待已领取的序号全部执行完毕。
+    size_t claimed = std::min(batch->next.fetch_add(count), count);
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->cv.wait(lock, [&] { return batch->finished >= claimed; });
+    if (batch->error) std::rethrow_exception(batch->error);
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// Minimal parallel-for used by codecs that split data into independent blocks.
+// 调用线程本身也参与计算，并负责报告进度/检查取消；任一任务抛出的异常会在所有线程结束后重新抛出。
+// 辅助线程来自进程内共享的线程池（最多 maxThreads() - 1 个），在池线程上的嵌套调用串行执行。
+namespace Parallel {
+// 0 表示使用硬件并发数。
+void setMaxThreads(size_t threads);
+size_t maxThreads();
+void forEach(size_t count, const std::function<void(size_t)> &fn);
+}
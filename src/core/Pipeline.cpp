@@ -0,0 +1,226 @@
+#include "Pipeline.h"
+#include "BoundedQueue.h"
+#include "Compressor.h"
+#include "Decompressor.h"
+#include "ImageData.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+struct Item {
+    size_t index = 0;
+    cv::Mat image;              // 压缩：读入的图像；解压：解码结果
+    std::vector<uint8_t> bytes; // 压缩：编码结果；解压：读入的文件内容
+};
+
+struct StageCounters {
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> busyNs{0};
+};
+
+// 记录单次处理的耗时，析构时累加到阶段计数器。
+class BusyTimer {
+public:
+    explicit BusyTimer(StageCounters &c) : counters(c), start(std::chrono::steady_clock::now()) {}
+    ~BusyTimer() {
+        counters.busyNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+private:
+    StageCounters &counters;
+    std::chrono::steady_clock::time_point start;
+};
+}
+
+struct Pipeline::Runner::State {
+    State(size_t jobCount, size_t capacity) : jobQueue(jobCount), readQueue(capacity), writeQueue(capacity) {}
+    BoundedQueue<size_t> jobQueue;
+    BoundedQueue<Item> readQueue;
+    BoundedQueue<Item> writeQueue;
+    StageCounters stage[3];
+    size_t threads[3] = {0, 0, 0};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point end;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> inputBytes{0};
+    std::atomic<uint64_t> outputBytes{0};
+    std::atomic<uint64_t> dedup[4] = {}; // tiles / unique / localRepeats / storeRepeats
+    std::mutex errorMutex;
+    std::vector<std::string> errors;
+
+    void fail(int stageIndex, const std::string &path, const std::exception &ex) {
+        stage[stageIndex].failed++;
+        std::lock_guard<std::mutex> lock(errorMutex);
+        errors.push_back(path + ": " + ex.what());
+    }
+};
+
+Pipeline::Runner::Runner(Config cfg) : config(std::move(cfg)) {
+    if (config.workers == 0) {
+        config.workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (config.readers == 0) config.readers = 1;
+    if (config.writers == 0) config.writers = 1;
+    Compressor::fileExtension(config.algo); // 提前校验算法名
+}
+
+Pipeline::Runner::~Runner() = default;
+
+Pipeline::Report Pipeline::Runner::run(const std::vector<Job> &jobs) {
+    auto st = std::make_shared<State>(jobs.size(), config.queueCapacity);
+    st->threads[0] = config.readers;
+    st->threads[1] = config.workers;
+    st->threads[2] = config.writers;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        state = st;
+    }
+    for (size_t i = 0; i < jobs.size(); ++i) st->jobQueue.push(i);
+    st->jobQueue.close();
+
+    const bool compress = config.mode == Mode::Compress;
+
+    // 读阶段：压缩时解码源图像，解压时整体读入压缩文件，主要耗时在磁盘/网络等待。
+    auto readStage = [&] {
+        size_t index;
+        while (st->jobQueue.pop(index)) {
+            Item item;
+            item.index = index;
+            try {
+                BusyTimer timer(st->stage[0]);
+                if (compress) {
+                    item.image = ImageIO::loadImage(jobs[index].inputPath, false);
+                    st->inputBytes += static_cast<uint64_t>(item.image.total() * item.image.elemSize());
+                } else {
+                    item.bytes = ImageIO::readFile(jobs[index].inputPath);
+                    st->inputBytes += item.bytes.size();
+                }
+            } catch (const std::exception &ex) {
+                st->fail(0, jobs[index].inputPath, ex);
+                continue;
+            }
+            st->stage[0].processed++;
+            st->readQueue.push(std::move(item));
+        }
+    };
+
+    // 编解码阶段：纯 CPU 计算，结果全部保存在内存中交给写阶段。
+    auto codecStage = [&] {
+        ColorTransform::Scope transformScope(config.transform);
+        Item item;
+        while (st->readQueue.pop(item)) {
+            try {
+                BusyTimer timer(st->stage[1]);
+                if (compress && config.tileSize) {
+                    Dedup::Stats stats;
+                    Dedup::compress(config.algo, item.image, config.tileSize, item.bytes, config.store, &stats);
+                    item.image.release();
+                    st->dedup[0] += stats.tiles;
+                    st->dedup[1] += stats.unique;
+                    st->dedup[2] += stats.localRepeats;
+                    st->dedup[3] += stats.storeRepeats;
+                } else if (compress) {
+                    Compressor::compressImage(config.algo, item.image, item.bytes, config.quality);
+                    item.image.release();
+                } else if (config.store && Dedup::isDedup(item.bytes.data(), item.bytes.size())) {
+                    item.image = Dedup::decompress(config.algo, item.bytes.data(), item.bytes.size(), config.store);
+                    item.bytes = std::vector<uint8_t>();
+                } else {
+                    item.image = Decompressor::decompressImage(config.algo, item.bytes.data(), item.bytes.size());
+                    item.bytes = std::vector<uint8_t>();
+                }
+            } catch (const std::exception &ex) {
+                st->fail(1, jobs[item.index].inputPath, ex);
+                continue;
+            }
+            st->stage[1].processed++;
+            st->writeQueue.push(std::move(item));
+        }
+    };
+
+    auto writeStage = [&] {
+        Item item;
+        while (st->writeQueue.pop(item)) {
+            const std::string &path = jobs[item.index].outputPath;
+            try {
+                BusyTimer timer(st->stage[2]);
+                if (compress) {
+                    ImageIO::writeFile(path, item.bytes);
+                    st->outputBytes += item.bytes.size();
+                } else {
+                    ImageIO::saveImage(path, item.image);
+                    st->outputBytes += static_cast<uint64_t>(item.image.total() * item.image.elemSize());
+                }
+            } catch (const std::exception &ex) {
+                st->fail(2, path, ex);
+                continue;
+            }
+            st->stage[2].processed++;
+        }
+    };
+
+    std::vector<std::thread> readers, workers, writers;
+    for (size_t i = 0; i < config.readers; ++i) readers.emplace_back(readStage);
+    for (size_t i = 0; i < config.workers; ++i) workers.emplace_back(codecStage);
+    for (size_t i = 0; i < config.writers; ++i) writers.emplace_back(writeStage);
+
+    // 按阶段顺序关闭队列：上游线程全部退出后下游才能看到队列结束。
+    for (auto &t : readers) t.join();
+    st->readQueue.close();
+    for (auto &t : workers) t.join();
+    st->writeQueue.close();
+    for (auto &t : writers) t.join();
+    st->end = std::chrono::steady_clock::now();
+    st->done = true;
+
+    Report report;
+    report.wallSeconds = std::chrono::duration<double>(st->end - st->start).count();
+    report.completed = st->stage[2].processed;
+    report.inputBytes = st->inputBytes;
+    report.outputBytes = st->outputBytes;
+    report.stages = snapshot();
+    report.errors = st->errors;
+    report.dedup.tiles = st->dedup[0];
+    report.dedup.unique = st->dedup[1];
+    report.dedup.localRepeats = st->dedup[2];
+    report.dedup.storeRepeats = st->dedup[3];
+    return report;
+}
+
+std::vector<Pipeline::StageStats> Pipeline::Runner::snapshot() const {
+    std::shared_ptr<State> st;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        st = state;
+    }
+    if (!st) return {};
+    auto now = st->done ? st->end : std::chrono::steady_clock::now();
+    double wall = std::chrono::duration<double>(now - st->start).count();
+    const char *names[3] = {"read", "codec", "write"};
+    std::vector<StageStats> out(3);
+    for (int i = 0; i < 3; ++i) {
+        StageStats &s = out[i];
+        s.name = names[i];
+        s.threads = st->threads[i];
+        s.processed = st->stage[i].processed;
+        s.failed = st->stage[i].failed;
+        s.busySeconds = st->stage[i].busyNs / 1e9;
+        s.utilization = (wall > 0 && s.threads) ? s.busySeconds / (wall * s.threads) : 0.0;
+    }
+    auto fillQueue = [](StageStats &s, const auto &q) {
+        s.queueCapacity = q.capacity();
+        s.queueDepth = q.size();
+        s.maxQueueDepth = q.maxDepth();
+        s.avgQueueDepth = q.averageDepth();
+        s.blockedSeconds = q.blockedSeconds();
+    };
+    fillQueue(out[0], st->jobQueue);
+    fillQueue(out[1], st->readQueue);
+    fillQueue(out[2], st->writeQueue);
+    return out;
+}
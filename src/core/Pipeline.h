@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ColorTransform.h"
+#include "Dedup.h"
+
+// Batch pipeline: read -> codec -> write stages connected by bounded queues.
+// 三个阶段各自拥有线程数，阶段之间用有界队列做背压，磁盘等待与编解码可以重叠进行。
+namespace Pipeline {
+enum class Mode { Compress, Decompress };
+
+struct Config {
+    std::string algo;
+    Mode mode = Mode::Compress;
+    int quality = 75;
+    ColorTransform::Kind transform = ColorTransform::Kind::None; // 无损编码前的颜色变换
+    size_t tileSize = 0; // 非 0 时压缩走分块去重（Dedup）
+    Dedup::Store *store = nullptr; // 批内共享块库，由调用方持有并负责保存
+    size_t readers = 2;
+    size_t workers = 0; // 0 表示使用硬件并发数
+    size_t writers = 2;
+    size_t queueCapacity = 8; // 每个阶段间队列的容量
+};
+
+struct Job {
+    std::string inputPath;
+    std::string outputPath;
+};
+
+// Per-stage counters; queue figures describe the stage's input queue.
+struct StageStats {
+    std::string name;
+    size_t threads = 0;
+    uint64_t processed = 0;
+    uint64_t failed = 0;
+    double busySeconds = 0.0;   // 所有线程累计的工作时间
+    double utilization = 0.0;   // busy / (wall * threads)
+    size_t queueCapacity = 0;
+    size_t queueDepth = 0;      // 快照时刻的深度
+    size_t maxQueueDepth = 0;
+    double avgQueueDepth = 0.0;
+    double blockedSeconds = 0.0; // 上游因该队列满而等待的时间
+};
+
+struct Report {
+    double wallSeconds = 0.0;
+    uint64_t completed = 0;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    std::vector<StageStats> stages;
+    std::vector<std::string> errors;
+    Dedup::Stats dedup; // 仅在 tileSize 非 0 的压缩批次中累计
+};
+
+class Runner {
+public:
+    explicit Runner(Config cfg);
+    ~Runner();
+    // 阻塞直到所有任务完成；单个文件失败只记录错误，不中断整批。
+    Report run(const std::vector<Job> &jobs);
+    // 线程安全，可在 run 执行期间从其他线程读取实时计数。
+    std::vector<StageStats> snapshot() const;
+
+private:
+    struct State;
+    Config config;
+    mutable std::mutex stateMutex;
+    std::shared_ptr<State> state;
+};
+}
@@ -0,0 +1,62 @@
+#include "PlaneCodec.h"
+#include "Huffman.h"
+#include "RLE.h"
+#include "LZ77.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+bool PlaneCodec::supports(Algorithm algo) {
+    return algo == Algorithm::Huffman || algo == Algorithm::RLE || algo == Algorithm::LZ77;
+}
+
+void PlaneCodec::encode(Algorithm algo, const std::vector<uint8_t> &plane, std::ostream &out) {
+    switch (algo) {
+        case Algorithm::Huffman:
+            Huffman::encodeBlocks(plane, out);
+            return;
+        case Algorithm::RLE: {
+            auto encoded = RLE::encodeChannel(plane);
+            uint32_t sz = static_cast<uint32_t>(encoded.size());
+            out.write(reinterpret_cast<const char*>(&sz), sizeof(uint32_t));
+            out.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+            return;
+        }
+        case Algorithm::LZ77: {
+            auto encoded = LZ77::encodeChannel(plane);
+            uint32_t sz = static_cast<uint32_t>(encoded.size());
+            out.write(reinterpret_cast<const char*>(&sz), sizeof(uint32_t));
+            out.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+            return;
+        }
+        default:
+            throw std::runtime_error("Plane coding supports huffman, rle and lz77 only");
+    }
+}
+
+std::vector<uint8_t> PlaneCodec::decode(Algorithm algo, std::istream &in, size_t rawSize) {
+    switch (algo) {
+        case Algorithm::Huffman:
+            return Huffman::decodeBlocks(in, rawSize);
+        case Algorithm::RLE: {
+            uint32_t sz = 0;
+            in.read(reinterpret_cast<char*>(&sz), sizeof(uint32_t));
+            std::vector<uint8_t> enc(sz);
+            in.read(reinterpret_cast<char*>(enc.data()), sz);
+            if (!in) throw std::runtime_error("Truncated RLE plane");
+            auto plane = RLE::decodeChannel(enc);
+            if (plane.size() != rawSize) throw std::runtime_error("RLE plane size mismatch");
+            return plane;
+        }
+        case Algorithm::LZ77: {
+            uint32_t sz = 0;
+            in.read(reinterpret_cast<char*>(&sz), sizeof(uint32_t));
+            std::vector<uint8_t> enc(sz);
+            in.read(reinterpret_cast<char*>(enc.data()), sz);
+            if (!in) throw std::runtime_error("Truncated LZ77 plane");
+            return LZ77::decodeChannel(enc.data(), enc.size(), rawSize);
+        }
+        default:
+            throw std::runtime_error("Plane coding supports huffman, rle and lz77 only");
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include "Compressor.h"
+
+// Codes a single byte plane with one of the lossless back-ends, without an image header.
+// 供容器格式（序列、残差等）复用现有熵编码器；每个平面自带长度信息，可直接顺序拼接。
+namespace PlaneCodec {
+// 目前支持 Huffman（分块格式）、RLE 与 LZ77，其它算法抛出异常。
+bool supports(Algorithm algo);
+void encode(Algorithm algo, const std::vector<uint8_t> &plane, std::ostream &out);
+std::vector<uint8_t> decode(Algorithm algo, std::istream &in, size_t rawSize);
+}
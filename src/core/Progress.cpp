@@ -0,0 +1,38 @@
+#include "Progress.h"
+
+namespace {
+thread_local const Progress::Listener *current = nullptr;
+thread_local double sectionBase = 0.0;
+thread_local double sectionSpan = 1.0;
+}
+
+Progress::Scope::Scope(const Listener &listener) : previous(current) {
+    current = &listener;
+}
+
+Progress::Scope::~Scope() {
+    current = previous;
+}
+
+Progress::Section::Section(uint64_t index, uint64_t count) : savedBase(sectionBase), savedSpan(sectionSpan) {
+    if (count == 0) count = 1;
+    report(index, count); // 在修改区间之前检查取消，构造抛异常时无需回滚
+    sectionBase = savedBase + savedSpan * static_cast<double>(index) / static_cast<double>(count);
+    sectionSpan = savedSpan / static_cast<double>(count);
+}
+
+Progress::Section::~Section() {
+    sectionBase = savedBase;
+    sectionSpan = savedSpan;
+}
+
+void Progress::report(uint64_t done, uint64_t total) {
+    const Listener *l = current;
+    if (!l) return;
+    if (l->cancelFlag && l->cancelFlag->load(std::memory_order_relaxed)) {
+        throw Cancelled();
+    }
+    if (l->onProgress && total > 0) {
+        l->onProgress(sectionBase + sectionSpan * static_cast<double>(done) / static_cast<double>(total));
+    }
+}
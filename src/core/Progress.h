@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
+// Lightweight progress reporting and cancellation for long-running codec calls.
+// 监听器按线程安装：编解码器只需在通道/块行等粒度调用 report，
+// 未安装监听器时开销仅为一次线程局部指针判断。
+namespace Progress {
+class Cancelled : public std::runtime_error {
+public:
+    Cancelled() : std::runtime_error("Operation cancelled") {}
+};
+
+struct Listener {
+    std::function<void(double fraction)> onProgress; // 0..1，可为空
+    const std::atomic<bool> *cancelFlag = nullptr;   // 置位后下一次 report 抛出 Cancelled
+};
+
+// RAII：在当前线程安装监听器，析构时恢复之前的监听器。
+class Scope {
+public:
+    explicit Scope(const Listener &listener);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+private:
+    const Listener *previous;
+};
+
+// 将嵌套调用报告的进度映射到外层区间的第 index/count 段，
+// 例如 RLE/LZW 逐通道编码时让每个通道只报告本通道内的进度。
+class Section {
+public:
+    Section(uint64_t index, uint64_t count);
+    ~Section();
+    Section(const Section &) = delete;
+    Section &operator=(const Section &) = delete;
+private:
+    double savedBase;
+    double savedSpan;
+};
+
+// 循环内建议的报告间隔（处理单位数），避免回调过于频繁。
+constexpr uint64_t kReportInterval = 1 << 16;
+
+// 报告已完成 done/total 个工作单位，并检查取消标志。
+void report(uint64_t done, uint64_t total);
+}
@@ -0,0 +1,149 @@
+#include "Pyramid.h"
+#include "Compressor.h"
+#include "Decompressor.h"
+#include "MemoryStream.h"
+#include "Progress.h"
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+// 2x2 均值缩小（四舍五入）；奇数边长时最后一行/列只与自身平均。
+cv::Mat halve(const cv::Mat &src) {
+    int w = (src.cols + 1) / 2, h = (src.rows + 1) / 2, cn = src.channels();
+    cv::Mat dst(h, w, src.type());
+    for (int y = 0; y < h; ++y) {
+        const uint8_t *r0 = src.ptr<uint8_t>(2 * y);
+        const uint8_t *r1 = src.ptr<uint8_t>(std::min(2 * y + 1, src.rows - 1));
+        uint8_t *out = dst.ptr<uint8_t>(y);
+        for (int x = 0; x < w; ++x) {
+            int x0 = 2 * x, x1 = std::min(2 * x + 1, src.cols - 1);
+            for (int c = 0; c < cn; ++c) {
+                int sum = r0[x0 * cn + c] + r0[x1 * cn + c] + r1[x0 * cn + c] + r1[x1 * cn + c];
+                out[x * cn + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+// 以粗一层的最近邻放大作为预测，sign=-1 计算残差（编码），sign=+1 加回残差（解码）。
+cv::Mat applyPrediction(const cv::Mat &fine, const cv::Mat &coarse, int sign) {
+    cv::Mat out(fine.rows, fine.cols, fine.type());
+    int cn = fine.channels();
+    for (int y = 0; y < fine.rows; ++y) {
+        const uint8_t *f = fine.ptr<uint8_t>(y);
+        const uint8_t *p = coarse.ptr<uint8_t>(y / 2);
+        uint8_t *o = out.ptr<uint8_t>(y);
+        for (int x = 0; x < fine.cols; ++x) {
+            for (int c = 0; c < cn; ++c) {
+                o[x * cn + c] = static_cast<uint8_t>(f[x * cn + c] + sign * p[(x / 2) * cn + c]);
+            }
+        }
+    }
+    return out;
+}
+
+void checkLossless(const std::string &algoName) {
+    if (!Compressor::isLossless(algoName)) {
+        throw std::runtime_error("Pyramid storage requires a lossless codec (huffman, rle, lzw or lz77)");
+    }
+}
+
+struct Header {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t channels = 0;
+    uint8_t levels = 0;
+};
+
+Header readHeader(std::istream &is) {
+    char magic[4];
+    is.read(magic, 4);
+    if (!is || std::string(magic, 4) != "PYR ") throw std::runtime_error("Invalid magic for pyramid");
+    Header h;
+    is.read(reinterpret_cast<char*>(&h.width), sizeof(uint32_t));
+    is.read(reinterpret_cast<char*>(&h.height), sizeof(uint32_t));
+    h.channels = static_cast<uint8_t>(is.get());
+    h.levels = static_cast<uint8_t>(is.get());
+    char pad[2]; is.read(pad, 2);
+    if (!is || h.levels == 0) throw std::runtime_error("Invalid pyramid header");
+    return h;
+}
+}
+
+bool Pyramid::isPyramid(const uint8_t *data, size_t size) {
+    return size >= 4 && std::memcmp(data, "PYR ", 4) == 0;
+}
+
+int Pyramid::levelCount(const uint8_t *data, size_t size) {
+    SpanStreamBuf buf(data, size);
+    std::istream is(&buf);
+    return readHeader(is).levels;
+}
+
+void Pyramid::compress(const std::string &algoName, const cv::Mat &img, int reductions, std::vector<uint8_t> &out) {
+    checkLossless(algoName);
+    if (reductions < 0 || reductions > 16) throw std::runtime_error("Pyramid reductions must be 0-16");
+    std::vector<cv::Mat> levels{img};
+    while (static_cast<int>(levels.size()) <= reductions && levels.back().cols > 1 && levels.back().rows > 1) {
+        levels.push_back(halve(levels.back()));
+    }
+
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    uint32_t width = static_cast<uint32_t>(img.cols), height = static_cast<uint32_t>(img.rows);
+    os.write("PYR ", 4);
+    os.write(reinterpret_cast<const char*>(&width), sizeof(uint32_t));
+    os.write(reinterpret_cast<const char*>(&height), sizeof(uint32_t));
+    os.put(static_cast<char>(img.channels()));
+    os.put(static_cast<char>(levels.size()));
+    os.put(0); os.put(0);
+
+    // 由粗到细：最粗层直接编码，其余层编码相对上一层的残差。每层前写 u64 编码长度。
+    std::vector<uint8_t> encoded;
+    for (size_t i = levels.size(); i-- > 0;) {
+        Progress::Section section(levels.size() - 1 - i, levels.size());
+        cv::Mat plane = i + 1 == levels.size() ? levels[i] : applyPrediction(levels[i], levels[i + 1], -1);
+        Compressor::compressImage(algoName, plane, encoded);
+        uint64_t size = encoded.size();
+        os.write(reinterpret_cast<const char*>(&size), sizeof(uint64_t));
+        os.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    }
+}
+
+cv::Mat Pyramid::decompress(const std::string &algoName, const uint8_t *data, size_t size, int level) {
+    SpanStreamBuf buf(data, size);
+    std::istream is(&buf);
+    Header h = readHeader(is);
+    if (level < 0) throw std::runtime_error("Pyramid level must be >= 0");
+    int target = std::min(level, h.levels - 1);
+    size_t offset = 16;
+    cv::Mat current;
+    for (int i = h.levels - 1; i >= target; --i) {
+        Progress::Section section(h.levels - 1 - i, h.levels - target);
+        uint64_t layerSize = 0;
+        if (size - offset < sizeof(uint64_t)) throw std::runtime_error("Truncated pyramid level");
+        std::memcpy(&layerSize, data + offset, sizeof(uint64_t));
+        offset += sizeof(uint64_t);
+        if (size - offset < layerSize) throw std::runtime_error("Truncated pyramid level");
+        cv::Mat plane = Decompressor::decompressImage(algoName, data + offset, static_cast<size_t>(layerSize));
+        offset += static_cast<size_t>(layerSize);
+        if (plane.channels() != h.channels) throw std::runtime_error("Pyramid level channel mismatch");
+        if (current.empty()) {
+            current = plane;
+            continue;
+        }
+        if ((plane.cols + 1) / 2 != current.cols || (plane.rows + 1) / 2 != current.rows) {
+            throw std::runtime_error("Pyramid level size mismatch");
+        }
+        current = applyPrediction(plane, current, 1);
+    }
+    if (target == 0 && (static_cast<uint32_t>(current.cols) != h.width || static_cast<uint32_t>(current.rows) != h.height)) {
+        throw std::runtime_error("Pyramid level size mismatch");
+    }
+    return current;
+}
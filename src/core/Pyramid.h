@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Multi-resolution container ("PYR ") for the lossless codecs.
+// 第 k 层为原图 2x2 均值逐级缩小 k 次的结果。文件先存最粗一层的完整图像，
+// 其后由粗到细存各层相对上一层最近邻放大的残差（模 256），每层都用所选编解码器独立编码。
+// 解码到第 L 层时只需读取并解码最粗层到第 L 层，无需触及更细的层。
+namespace Pyramid {
+// reductions 为缩小次数（存储 reductions+1 层），遇到 1 像素宽/高时提前停止。仅支持无损算法。
+void compress(const std::string &algoName, const cv::Mat &img, int reductions, std::vector<uint8_t> &out);
+// level 0 为原始分辨率，level k 为 1/2^k；超过已存层数时返回最粗一层。
+cv::Mat decompress(const std::string &algoName, const uint8_t *data, size_t size, int level = 0);
+bool isPyramid(const uint8_t *data, size_t size);
+// 已存储的层数（含原始分辨率层）。
+int levelCount(const uint8_t *data, size_t size);
+}
@@ -1,12 +1,21 @@
 #include "RLE.h"
-#include <fstream>
+#include "MemProfile.h"
+#include "MemoryStream.h"
+#include "Progress.h"
+#include <istream>
+#include <ostream>
 #include <stdexcept>
 
 // Simple RLE: (value, run_length uint16_t)
 std::vector<uint8_t> RLE::encodeChannel(const std::vector<uint8_t> &data) {
     std::vector<uint8_t> out;
     size_t i = 0;
+    size_t nextReport = 0;
     while (i < data.size()) {
+        if (i >= nextReport) {
+            Progress::report(i, data.size());
+            nextReport = i + Progress::kReportInterval;
+        }
         uint8_t val = data[i];
         uint16_t run = 1;
         while (i + run < data.size() && data[i + run] == val && run < 0xFFFF) {
@@ -23,6 +32,7 @@ std::vector<uint8_t> RLE::encodeChannel(const std::vector<uint8_t> &data) {
 std::vector<uint8_t> RLE::decodeChannel(const std::vector<uint8_t> &data) {
     std::vector<uint8_t> out;
     for (size_t i = 0; i + 2 < data.size(); i += 3) {
+        if (i % (Progress::kReportInterval * 3) == 0) Progress::report(i, data.size());
         uint8_t val = data[i];
         uint16_t run = static_cast<uint16_t>(data[i+1] << 8 | data[i+2]);
         out.insert(out.end(), run, val);
@@ -31,16 +41,29 @@ std::vector<uint8_t> RLE::decodeChannel(const std::vector<uint8_t> &data) {
 }
 
 void RLE::compress(const cv::Mat &img, const std::string &outputPath) {
-    ImageData data = ImageIO::fromMat(img);
-    std::ofstream ofs(outputPath, std::ios::binary);
-    if (!ofs) throw std::runtime_error("Cannot open output file");
+    std::vector<uint8_t> buffer;
+    compress(img, buffer);
+    ImageIO::writeFile(outputPath, buffer);
+}
+
+void RLE::compress(const cv::Mat &img, std::vector<uint8_t> &out) {
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    compress(img, os);
+}
+
+void RLE::compress(const cv::Mat &img, std::ostream &ofs) {
+    MemProfile::Scope memScope("rle");
+    ImageData data = ImageIO::fromMat(img, ColorTransform::current());
     ofs.write("RLE ", 4);
     ofs.write(reinterpret_cast<const char*>(&data.width), sizeof(uint32_t));
     ofs.write(reinterpret_cast<const char*>(&data.height), sizeof(uint32_t));
     ofs.put(static_cast<char>(data.channels));
-    ofs.put(0); ofs.put(0); ofs.put(0);
-    for (const auto &ch : data.channelData) {
-        auto encoded = encodeChannel(ch);
+    ofs.put(0); ofs.put(static_cast<char>(data.transform)); ofs.put(0);
+    for (size_t c = 0; c < data.channelData.size(); ++c) {
+        Progress::Section section(c, data.channelData.size());
+        auto encoded = encodeChannel(data.channelData[c]);
         uint32_t sz = static_cast<uint32_t>(encoded.size());
         ofs.write(reinterpret_cast<const char*>(&sz), sizeof(uint32_t));
         ofs.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
@@ -48,8 +71,18 @@ void RLE::compress(const cv::Mat &img, const std::string &outputPath) {
 }
 
 cv::Mat RLE::decompress(const std::string &inputPath) {
-    std::ifstream ifs(inputPath, std::ios::binary);
-    if (!ifs) throw std::runtime_error("Cannot open input file");
+    std::vector<uint8_t> buffer = ImageIO::readFile(inputPath);
+    return decompress(buffer.data(), buffer.size());
+}
+
+cv::Mat RLE::decompress(const uint8_t *data, size_t size) {
+    SpanStreamBuf buf(data, size);
+    std::istream is(&buf);
+    return decompress(is);
+}
+
+cv::Mat RLE::decompress(std::istream &ifs) {
+    MemProfile::Scope memScope("rle");
     char magic[4];
     ifs.read(magic, 4);
     if (std::string(magic,4) != "RLE ") throw std::runtime_error("Invalid magic for RLE");
@@ -58,8 +91,12 @@ cv::Mat RLE::decompress(const std::string &inputPath) {
     ifs.read(reinterpret_cast<char*>(&data.height), sizeof(uint32_t));
     ifs.read(reinterpret_cast<char*>(&data.channels), 1);
     char pad[3]; ifs.read(pad, 3);
+    if (!ColorTransform::isKnown(static_cast<uint8_t>(pad[1]))) throw std::runtime_error("Unsupported RLE colour transform");
+    data.transform = static_cast<ColorTransform::Kind>(pad[1]);
     data.channelData.resize(data.channels);
-    for (auto &ch : data.channelData) {
+    for (size_t c = 0; c < data.channelData.size(); ++c) {
+        Progress::Section section(c, data.channelData.size());
+        auto &ch = data.channelData[c];
         uint32_t sz = 0;
         ifs.read(reinterpret_cast<char*>(&sz), sizeof(uint32_t));
         std::vector<uint8_t> enc(sz);
@@ -2,11 +2,16 @@
 #include <vector>
 #include <cstdint>
 #include <string>
+#include <iosfwd>
 #include "ImageData.h"
 
 namespace RLE {
 std::vector<uint8_t> encodeChannel(const std::vector<uint8_t> &data);
 std::vector<uint8_t> decodeChannel(const std::vector<uint8_t> &data);
 void compress(const cv::Mat &img, const std::string &outputPath);
+void compress(const cv::Mat &img, std::ostream &out);
+void compress(const cv::Mat &img, std::vector<uint8_t> &out);
 cv::Mat decompress(const std::string &inputPath);
+cv::Mat decompress(std::istream &in);
+cv::Mat decompress(const uint8_t *data, size_t size);
 }
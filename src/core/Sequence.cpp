@@ -0,0 +1,280 @@
+#include "Sequence.h"
+#include "MemoryStream.h"
+#include "PlaneCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+const uint8_t kKeyframe = 0;
+const uint8_t kDelta = 1;
+
+Algorithm parseAlgo(const std::string &name) {
+    if (name == "huffman") return Algorithm::Huffman;
+    if (name == "rle") return Algorithm::RLE;
+    if (name == "lz77") return Algorithm::LZ77;
+    throw std::runtime_error("Sequence mode supports huffman, rle and lz77 back-ends, got: " + name);
+}
+
+// 头部算法字节与枚举的显式对应表，与 Algorithm 的声明顺序解耦；已写入文件的取值不可再改。
+struct AlgoByte {
+    Algorithm algo;
+    uint8_t code;
+};
+const AlgoByte kAlgoBytes[] = {
+    {Algorithm::Huffman, 0},
+    {Algorithm::RLE, 1},
+    {Algorithm::LZ77, 5},
+};
+
+uint8_t algoToByte(Algorithm algo) {
+    for (const auto &entry : kAlgoBytes) {
+        if (entry.algo == algo) return entry.code;
+    }
+    throw std::runtime_error("Algorithm not supported in sequence mode");
+}
+
+bool algoFromByte(uint8_t code, Algorithm &algo) {
+    for (const auto &entry : kAlgoBytes) {
+        if (entry.code == code) {
+            algo = entry.algo;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 按行优先遍历所有块（右/下边缘的块按图像边界裁剪），对每个块调用 fn(index, x0, y0, x1, y1)。
+template <typename Fn>
+void forEachBlock(uint32_t width, uint32_t height, uint32_t blockSize, Fn fn) {
+    size_t index = 0;
+    for (uint32_t y = 0; y < height; y += blockSize) {
+        for (uint32_t x = 0; x < width; x += blockSize) {
+            fn(index++, x, y, std::min(x + blockSize, width), std::min(y + blockSize, height));
+        }
+    }
+}
+
+size_t blockCount(uint32_t width, uint32_t height, uint32_t blockSize) {
+    return static_cast<size_t>((width + blockSize - 1) / blockSize) * ((height + blockSize - 1) / blockSize);
+}
+}
+
+Sequence::Encoder::Encoder(std::ostream &output, Config cfg) : out(output), config(std::move(cfg)) {
+    algo = parseAlgo(config.algo);
+    if (config.keyframeInterval == 0) config.keyframeInterval = 1;
+    if (config.blockSize == 0 || config.blockSize > 255) throw std::runtime_error("Block size must be 1-255");
+}
+
+void Sequence::Encoder::write(const std::vector<uint8_t> &bytes) {
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!out) throw std::runtime_error("Failed to write sequence");
+    counters.bytes += bytes.size();
+}
+
+void Sequence::Encoder::writeHeader(const ImageData &first) {
+    buffer.clear();
+    VectorStreamBuf buf(buffer);
+    std::ostream os(&buf);
+    os.write("SEQ ", 4);
+    os.write(reinterpret_cast<const char*>(&first.width), sizeof(uint32_t));
+    os.write(reinterpret_cast<const char*>(&first.height), sizeof(uint32_t));
+    os.put(static_cast<char>(first.channels));
+    os.put(static_cast<char>(algoToByte(algo)));
+    os.put(static_cast<char>(config.blockSize));
+    os.put(0);
+    os.write(reinterpret_cast<const char*>(&config.keyframeInterval), sizeof(uint32_t));
+    write(buffer);
+}
+
+void Sequence::Encoder::addFrame(const cv::Mat &frame) {
+    if (finished) throw std::runtime_error("Sequence already finished");
+    ImageData cur = ImageIO::fromMat(frame);
+    if (counters.frames == 0) {
+        writeHeader(cur);
+    } else if (cur.width != previous.width || cur.height != previous.height || cur.channels != previous.channels) {
+        throw std::runtime_error("All frames in a sequence must share size and channel count");
+    }
+
+    bool key = counters.frames % config.keyframeInterval == 0;
+    buffer.clear();
+    VectorStreamBuf buf(buffer);
+    std::ostream os(&buf);
+    os.put(static_cast<char>(key ? kKeyframe : kDelta));
+    os.put(0); os.put(0); os.put(0);
+    if (key) {
+        for (const auto &plane : cur.channelData) PlaneCodec::encode(algo, plane, os);
+        counters.keyframes++;
+    } else {
+        // 逐块比较与上一重建帧（无损，即上一帧本身）的差异，只收集变化块的残差。
+        size_t blocks = blockCount(cur.width, cur.height, config.blockSize);
+        std::vector<uint8_t> bitmap((blocks + 7) / 8, 0);
+        std::vector<std::vector<uint8_t>> residual(cur.channels);
+        uint32_t changed = 0;
+        forEachBlock(cur.width, cur.height, config.blockSize, [&](size_t index, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+            bool differs = false;
+            for (size_t c = 0; c < cur.channelData.size() && !differs; ++c) {
+                for (uint32_t y = y0; y < y1 && !differs; ++y) {
+                    size_t row = static_cast<size_t>(y) * cur.width;
+                    differs = std::memcmp(&cur.channelData[c][row + x0], &previous.channelData[c][row + x0], x1 - x0) != 0;
+                }
+            }
+            if (!differs) return;
+            bitmap[index / 8] |= static_cast<uint8_t>(0x80 >> (index % 8));
+            changed++;
+            for (size_t c = 0; c < cur.channelData.size(); ++c) {
+                for (uint32_t y = y0; y < y1; ++y) {
+                    size_t row = static_cast<size_t>(y) * cur.width;
+                    for (uint32_t x = x0; x < x1; ++x) {
+                        residual[c].push_back(static_cast<uint8_t>(cur.channelData[c][row + x] - previous.channelData[c][row + x]));
+                    }
+                }
+            }
+        });
+        os.write(reinterpret_cast<const char*>(&changed), sizeof(uint32_t));
+        os.write(reinterpret_cast<const char*>(bitmap.data()), static_cast<std::streamsize>(bitmap.size()));
+        if (changed) {
+            for (const auto &plane : residual) PlaneCodec::encode(algo, plane, os);
+        }
+        counters.totalBlocks += blocks;
+        counters.changedBlocks += changed;
+    }
+
+    offsets.push_back(counters.bytes);
+    types.push_back(key ? kKeyframe : kDelta);
+    write(buffer);
+    counters.frames++;
+    previous = std::move(cur);
+}
+
+void Sequence::Encoder::finish() {
+    if (finished) return;
+    if (counters.frames == 0) throw std::runtime_error("Sequence has no frames");
+    finished = true;
+    // 索引：每帧 u64 偏移 + u8 类型；文件最后 8 字节为索引起始偏移，解码端据此定位。
+    uint64_t indexOffset = counters.bytes;
+    buffer.clear();
+    VectorStreamBuf buf(buffer);
+    std::ostream os(&buf);
+    os.write("SIDX", 4);
+    uint32_t count = static_cast<uint32_t>(offsets.size());
+    os.write(reinterpret_cast<const char*>(&count), sizeof(uint32_t));
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        os.write(reinterpret_cast<const char*>(&offsets[i]), sizeof(uint64_t));
+        os.put(static_cast<char>(types[i]));
+        os.put(0); os.put(0); os.put(0);
+    }
+    os.write(reinterpret_cast<const char*>(&indexOffset), sizeof(uint64_t));
+    write(buffer);
+    out.flush();
+}
+
+Sequence::Decoder::Decoder(const std::string &inputPath) : bytes(ImageIO::readFile(inputPath)) {
+    parse();
+}
+
+Sequence::Decoder::Decoder(std::vector<uint8_t> data) : bytes(std::move(data)) {
+    parse();
+}
+
+void Sequence::Decoder::parse() {
+    if (bytes.size() < 28 || std::memcmp(bytes.data(), "SEQ ", 4) != 0) {
+        throw std::runtime_error("Invalid magic for sequence");
+    }
+    SpanStreamBuf buf(bytes.data(), bytes.size());
+    std::istream is(&buf);
+    is.seekg(4);
+    is.read(reinterpret_cast<char*>(&header.width), sizeof(uint32_t));
+    is.read(reinterpret_cast<char*>(&header.height), sizeof(uint32_t));
+    header.channels = static_cast<uint8_t>(is.get());
+    uint8_t algoByte = static_cast<uint8_t>(is.get());
+    blockSize = static_cast<uint8_t>(is.get());
+    if (!algoFromByte(algoByte, algo) || !PlaneCodec::supports(algo) || blockSize == 0 ||
+        (header.channels != 1 && header.channels != 3)) {
+        throw std::runtime_error("Unsupported sequence header");
+    }
+
+    // 比较时先减后比，避免构造的 indexOffset / count 让加法回绕后越界读取。
+    uint64_t indexOffset = 0;
+    std::memcpy(&indexOffset, bytes.data() + bytes.size() - sizeof(uint64_t), sizeof(uint64_t));
+    if (indexOffset > bytes.size() - 16 || std::memcmp(bytes.data() + indexOffset, "SIDX", 4) != 0) {
+        throw std::runtime_error("Sequence index missing or corrupted");
+    }
+    is.seekg(static_cast<std::streamoff>(indexOffset + 4));
+    uint32_t count = 0;
+    is.read(reinterpret_cast<char*>(&count), sizeof(uint32_t));
+    uint64_t entryBytes = bytes.size() - 16 - indexOffset; // 去掉 "SIDX"、count 与末尾的偏移
+    if (entryBytes % 12 != 0 || count != entryBytes / 12) {
+        throw std::runtime_error("Sequence index missing or corrupted");
+    }
+    offsets.resize(count);
+    types.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        is.read(reinterpret_cast<char*>(&offsets[i]), sizeof(uint64_t));
+        types[i] = static_cast<uint8_t>(is.get());
+        char pad[3]; is.read(pad, 3);
+        if (offsets[i] >= indexOffset) throw std::runtime_error("Sequence index missing or corrupted");
+    }
+    if (count == 0 || types[0] != kKeyframe) throw std::runtime_error("Sequence must start with a keyframe");
+}
+
+void Sequence::Decoder::decodeInto(size_t index, ImageData &image) {
+    SpanStreamBuf buf(bytes.data(), bytes.size());
+    std::istream is(&buf);
+    is.seekg(static_cast<std::streamoff>(offsets[index]));
+    uint8_t type = static_cast<uint8_t>(is.get());
+    char pad[3]; is.read(pad, 3);
+    size_t pixels = static_cast<size_t>(header.width) * header.height;
+    if (type == kKeyframe) {
+        image.width = header.width;
+        image.height = header.height;
+        image.channels = header.channels;
+        image.channelData.resize(header.channels);
+        for (auto &plane : image.channelData) plane = PlaneCodec::decode(algo, is, pixels);
+        return;
+    }
+    if (type != kDelta) throw std::runtime_error("Unknown sequence frame type");
+
+    size_t blocks = blockCount(header.width, header.height, blockSize);
+    uint32_t changed = 0;
+    is.read(reinterpret_cast<char*>(&changed), sizeof(uint32_t));
+    std::vector<uint8_t> bitmap((blocks + 7) / 8);
+    is.read(reinterpret_cast<char*>(bitmap.data()), static_cast<std::streamsize>(bitmap.size()));
+    if (!is) throw std::runtime_error("Truncated sequence frame");
+    if (changed == 0) return;
+
+    size_t residualSize = 0;
+    forEachBlock(header.width, header.height, blockSize, [&](size_t i, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+        if (bitmap[i / 8] & (0x80 >> (i % 8))) residualSize += static_cast<size_t>(x1 - x0) * (y1 - y0);
+    });
+    for (size_t c = 0; c < image.channelData.size(); ++c) {
+        std::vector<uint8_t> residual = PlaneCodec::decode(algo, is, residualSize);
+        auto &plane = image.channelData[c];
+        size_t pos = 0;
+        forEachBlock(header.width, header.height, blockSize, [&](size_t i, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+            if (!(bitmap[i / 8] & (0x80 >> (i % 8)))) return;
+            for (uint32_t y = y0; y < y1; ++y) {
+                size_t row = static_cast<size_t>(y) * header.width;
+                for (uint32_t x = x0; x < x1; ++x) plane[row + x] = static_cast<uint8_t>(plane[row + x] + residual[pos++]);
+            }
+        });
+    }
+}
+
+cv::Mat Sequence::Decoder::frame(size_t index) {
+    if (index >= offsets.size()) throw std::runtime_error("Frame index out of range");
+    size_t key = index;
+    while (types[key] != kKeyframe) --key;
+    size_t start = key;
+    if (currentIndex != SIZE_MAX && currentIndex >= key && currentIndex <= index) {
+        start = currentIndex + 1;
+    }
+    for (size_t i = start; i <= index; ++i) {
+        currentIndex = SIZE_MAX; // 解码中途失败时不保留半成品状态
+        decodeInto(i, current);
+        currentIndex = i;
+    }
+    return ImageIO::toMat(current);
+}
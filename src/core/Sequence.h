@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "Compressor.h"
+#include "ImageData.h"
+
+// Inter-frame sequence container ("SEQ "): periodic keyframes plus delta frames.
+// 差分帧记录相对上一重建帧的逐字节差值（模 256，无损），只编码发生变化的块，
+// 未变化的块在位图中只占 1 bit。文件末尾带帧索引，解码时可定位到最近的关键帧再向后重建。
+namespace Sequence {
+struct Config {
+    std::string algo = "huffman";   // 残差与关键帧平面使用的后端：huffman | rle | lz77
+    uint32_t keyframeInterval = 30;  // 每 N 帧强制一个关键帧；1 表示全部为关键帧
+    uint32_t blockSize = 16;         // 变化检测块边长（像素），8 或 16 较合适
+};
+
+struct Stats {
+    uint64_t frames = 0;
+    uint64_t keyframes = 0;
+    uint64_t totalBlocks = 0;   // 所有差分帧的块总数
+    uint64_t changedBlocks = 0; // 其中发生变化的块数
+    uint64_t bytes = 0;         // 已写出的字节数（含头部与索引）
+};
+
+// 帧逐个写入输出流；所有帧尺寸和通道数必须与第一帧相同。不要求输出流可定位。
+class Encoder {
+public:
+    Encoder(std::ostream &out, Config cfg);
+    void addFrame(const cv::Mat &frame);
+    // 写出帧索引与尾部；之后不能再添加帧。
+    void finish();
+    const Stats &stats() const { return counters; }
+
+private:
+    void writeHeader(const ImageData &first);
+    void write(const std::vector<uint8_t> &bytes);
+
+    std::ostream &out;
+    Config config;
+    Algorithm algo;
+    Stats counters;
+    ImageData previous;
+    std::vector<uint64_t> offsets;
+    std::vector<uint8_t> types;
+    std::vector<uint8_t> buffer;
+    bool finished = false;
+};
+
+class Decoder {
+public:
+    explicit Decoder(const std::string &inputPath);
+    explicit Decoder(std::vector<uint8_t> data);
+
+    size_t frameCount() const { return offsets.size(); }
+    bool isKeyframe(size_t index) const { return types.at(index) == 0; }
+    uint32_t width() const { return header.width; }
+    uint32_t height() const { return header.height; }
+    // 随机访问：若请求的帧紧随上次解码的帧则直接续解，否则从不晚于它的最近关键帧开始重建。
+    cv::Mat frame(size_t index);
+
+private:
+    void parse();
+    void decodeInto(size_t index, ImageData &image);
+
+    std::vector<uint8_t> bytes;
+    ImageData header;
+    Algorithm algo = Algorithm::Huffman;
+    uint32_t blockSize = 16;
+    std::vector<uint64_t> offsets;
+    std::vector<uint8_t> types;
+    ImageData current;
+    size_t currentIndex = SIZE_MAX;
+};
+}
@@ -0,0 +1,428 @@
+#include "WaveletCodec.h"
+#include "Huffman.h"
+#include "MemProfile.h"
+#include "MemoryStream.h"
+#include "Parallel.h"
+#include "Progress.h"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+const uint8_t kFilter53 = 0;
+const uint8_t kFilter97 = 1;
+// 编码器分解级数上限；解码时拒绝更大的值，避免 1u << skip 等移位越界。
+const int kMaxLevels = 16;
+
+// CDF 9/7 提升系数；低通乘 K、高通除以 K 后变换近似正交，各子带可用同一量化步长。
+const float kAlpha = -1.586134342f;
+const float kBeta = -0.05298011854f;
+const float kGamma = 0.8829110762f;
+const float kDelta = 0.4435068522f;
+const float kK = 1.149604398f;
+
+// 1D 提升均在交织序列上原地进行（偶数位为低通、奇数位为高通），两端对称延拓，
+// 最后拆分为 [低通 | 高通]。n 为奇数时低通比高通多一个。
+void forward53(int32_t *x, int n, int32_t *tmp) {
+    if (n < 2) return;
+    int nl = (n + 1) / 2, nh = n / 2;
+    for (int i = 0; i < nh; ++i) {
+        int32_t right = 2 * i + 2 < n ? x[2 * i + 2] : x[2 * i];
+        x[2 * i + 1] -= (x[2 * i] + right) >> 1;
+    }
+    for (int i = 0; i < nl; ++i) {
+        int32_t dl = i > 0 ? x[2 * i - 1] : x[1];
+        int32_t dr = 2 * i + 1 < n ? x[2 * i + 1] : x[2 * i - 1];
+        x[2 * i] += (dl + dr + 2) >> 2;
+    }
+    for (int i = 0; i < nl; ++i) tmp[i] = x[2 * i];
+    for (int i = 0; i < nh; ++i) tmp[nl + i] = x[2 * i + 1];
+    std::copy(tmp, tmp + n, x);
+}
+
+void inverse53(int32_t *x, int n, int32_t *tmp) {
+    if (n < 2) return;
+    int nl = (n + 1) / 2, nh = n / 2;
+    for (int i = 0; i < nl; ++i) tmp[2 * i] = x[i];
+    for (int i = 0; i < nh; ++i) tmp[2 * i + 1] = x[nl + i];
+    for (int i = 0; i < nl; ++i) {
+        int32_t dl = i > 0 ? tmp[2 * i - 1] : tmp[1];
+        int32_t dr = 2 * i + 1 < n ? tmp[2 * i + 1] : tmp[2 * i - 1];
+        tmp[2 * i] -= (dl + dr + 2) >> 2;
+    }
+    for (int i = 0; i < nh; ++i) {
+        int32_t right = 2 * i + 2 < n ? tmp[2 * i + 2] : tmp[2 * i];
+        tmp[2 * i + 1] += (tmp[2 * i] + right) >> 1;
+    }
+    std::copy(tmp, tmp + n, x);
+}
+
+// 对奇数（parity=1）或偶数（parity=0）位置执行一步提升：x[k] += c * (左邻 + 右邻)。
+void liftStep(float *x, int n, int parity, float c) {
+    for (int k = parity; k < n; k += 2) {
+        float left = k > 0 ? x[k - 1] : x[k + 1];
+        float right = k + 1 < n ? x[k + 1] : x[k - 1];
+        x[k] += c * (left + right);
+    }
+}
+
+void forward97(float *x, int n, float *tmp) {
+    if (n < 2) return;
+    liftStep(x, n, 1, kAlpha);
+    liftStep(x, n, 0, kBeta);
+    liftStep(x, n, 1, kGamma);
+    liftStep(x, n, 0, kDelta);
+    int nl = (n + 1) / 2, nh = n / 2;
+    for (int i = 0; i < nl; ++i) tmp[i] = x[2 * i] * kK;
+    for (int i = 0; i < nh; ++i) tmp[nl + i] = x[2 * i + 1] / kK;
+    std::copy(tmp, tmp + n, x);
+}
+
+void inverse97(float *x, int n, float *tmp) {
+    if (n < 2) return;
+    int nl = (n + 1) / 2, nh = n / 2;
+    for (int i = 0; i < nl; ++i) tmp[2 * i] = x[i] / kK;
+    for (int i = 0; i < nh; ++i) tmp[2 * i + 1] = x[nl + i] * kK;
+    liftStep(tmp, n, 0, -kDelta);
+    liftStep(tmp, n, 1, -kGamma);
+    liftStep(tmp, n, 0, -kBeta);
+    liftStep(tmp, n, 1, -kAlpha);
+    std::copy(tmp, tmp + n, x);
+}
+
+// 对 plane 左上角 w x h 区域做一级 2D 变换：先行后列。列变换先收集到连续缓冲区，避免跨步访问。
+template <typename T, typename Lift>
+void transform2D(std::vector<T> &plane, int stride, int w, int h, bool rowsFirst, Lift lift) {
+    std::vector<T> line(std::max(w, h)), tmp(std::max(w, h));
+    auto rows = [&] {
+        for (int y = 0; y < h; ++y) lift(&plane[static_cast<size_t>(y) * stride], w, tmp.data());
+    };
+    auto cols = [&] {
+        for (int x = 0; x < w; ++x) {
+            for (int y = 0; y < h; ++y) line[y] = plane[static_cast<size_t>(y) * stride + x];
+            lift(line.data(), h, tmp.data());
+            for (int y = 0; y < h; ++y) plane[static_cast<size_t>(y) * stride + x] = line[y];
+        }
+    };
+    if (rowsFirst) {
+        rows();
+        cols();
+    } else {
+        cols();
+        rows();
+    }
+}
+
+int levelSize(int size, int level) {
+    for (int i = 0; i < level; ++i) size = (size + 1) / 2;
+    return size;
+}
+
+struct Rect {
+    int x0, y0, x1, y1;
+};
+
+// 分辨率 r 的子带：r=0 为最粗的 LL，r>=1 为第 (levels-r+1) 级分解的 HL、LH、HH。
+std::vector<Rect> resolutionBands(int width, int height, int levels, int r) {
+    if (r == 0) {
+        return {{0, 0, levelSize(width, levels), levelSize(height, levels)}};
+    }
+    int level = levels - r + 1;
+    int w = levelSize(width, level - 1), h = levelSize(height, level - 1);
+    int lw = (w + 1) / 2, lh = (h + 1) / 2;
+    return {{lw, 0, w, lh}, {0, lh, lw, h}, {lw, lh, w, h}};
+}
+
+// 子带系数的字节符号：非零值写 zigzag varint（首字节必不为 0），连续的 0 写 0x00 + varint(游程-1)。
+void appendVarint(std::vector<uint8_t> &out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+uint32_t readVarint(const std::vector<uint8_t> &in, size_t &pos) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= in.size()) throw std::runtime_error("Truncated wavelet subband");
+        uint8_t b = in[pos++];
+        v |= static_cast<uint32_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    throw std::runtime_error("Invalid wavelet varint");
+}
+
+void appendBand(const std::vector<int32_t> &q, int stride, const Rect &band, std::vector<uint8_t> &out) {
+    uint32_t run = 0;
+    for (int y = band.y0; y < band.y1; ++y) {
+        for (int x = band.x0; x < band.x1; ++x) {
+            int32_t v = q[static_cast<size_t>(y) * stride + x];
+            if (v == 0) {
+                ++run;
+                continue;
+            }
+            if (run) {
+                out.push_back(0);
+                appendVarint(out, run - 1);
+                run = 0;
+            }
+            appendVarint(out, (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31));
+        }
+    }
+    if (run) {
+        out.push_back(0);
+        appendVarint(out, run - 1);
+    }
+}
+
+void readBand(const std::vector<uint8_t> &in, size_t &pos, std::vector<int32_t> &q, int stride, const Rect &band) {
+    uint32_t run = 0;
+    for (int y = band.y0; y < band.y1; ++y) {
+        for (int x = band.x0; x < band.x1; ++x) {
+            int32_t &dst = q[static_cast<size_t>(y) * stride + x];
+            if (run) {
+                --run;
+                dst = 0;
+                continue;
+            }
+            if (pos >= in.size()) throw std::runtime_error("Truncated wavelet subband");
+            if (in[pos] == 0) {
+                ++pos;
+                run = readVarint(in, pos);
+                dst = 0;
+                continue;
+            }
+            uint32_t z = readVarint(in, pos);
+            dst = static_cast<int32_t>(z >> 1) ^ -static_cast<int32_t>(z & 1);
+        }
+    }
+    if (run) throw std::runtime_error("Wavelet zero run overflows subband");
+}
+
+// 9/7 量化步长：质量每降低 12.5，步长翻倍；quality 99 约为 1。
+float stepForQuality(int quality) {
+    return std::pow(2.0f, (100 - quality) / 12.5f);
+}
+
+struct Header {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t channels = 0;
+    uint8_t levels = 0;
+    uint8_t filter = kFilter53;
+    uint8_t quality = 100;
+};
+}
+
+void WaveletCodec::compress(const cv::Mat &img, const std::string &outputPath, int quality) {
+    std::vector<uint8_t> buffer;
+    compress(img, buffer, quality);
+    ImageIO::writeFile(outputPath, buffer);
+}
+
+void WaveletCodec::compress(const cv::Mat &img, std::vector<uint8_t> &out, int quality) {
+    out.clear();
+    VectorStreamBuf buf(out);
+    std::ostream os(&buf);
+    compress(img, os, quality);
+}
+
+void WaveletCodec::compress(const cv::Mat &img, std::ostream &ofs, int quality, int levels) {
+    MemProfile::Scope memScope("wavelet");
+    if (quality < 1 || quality > 100) throw std::runtime_error("Quality must be 1-100");
+    ImageData data = ImageIO::fromMat(img);
+    Header h;
+    h.width = data.width;
+    h.height = data.height;
+    h.channels = data.channels;
+    h.filter = quality == 100 ? kFilter53 : kFilter97;
+    h.quality = static_cast<uint8_t>(quality);
+    // 分解到最粗层两边都不小于 1 像素为止。
+    int maxLevels = 0;
+    while (maxLevels < kMaxLevels && (data.width >> (maxLevels + 1)) > 0 && (data.height >> (maxLevels + 1)) > 0) ++maxLevels;
+    h.levels = static_cast<uint8_t>(std::clamp(levels, 0, maxLevels));
+
+    int w = static_cast<int>(h.width), ht = static_cast<int>(h.height);
+    // 每个通道得到整数系数平面：5/3 直接为变换结果，9/7 为量化索引。
+    std::vector<std::vector<int32_t>> coeffs(h.channels);
+    float step = stepForQuality(quality);
+    Parallel::forEach(h.channels, [&](size_t c) {
+        const auto &src = data.channelData[c];
+        if (h.filter == kFilter53) {
+            std::vector<int32_t> plane(src.size());
+            for (size_t i = 0; i < src.size(); ++i) plane[i] = static_cast<int32_t>(src[i]) - 128;
+            for (int l = 0; l < h.levels; ++l) {
+                transform2D(plane, w, levelSize(w, l), levelSize(ht, l), true, forward53);
+            }
+            coeffs[c] = std::move(plane);
+        } else {
+            std::vector<float> plane(src.size());
+            for (size_t i = 0; i < src.size(); ++i) plane[i] = static_cast<float>(src[i]) - 128.0f;
+            for (int l = 0; l < h.levels; ++l) {
+                transform2D(plane, w, levelSize(w, l), levelSize(ht, l), true, forward97);
+            }
+            // 高频子带用死区量化（向零截断），LL 四舍五入。
+            int llW = levelSize(w, h.levels), llH = levelSize(ht, h.levels);
+            std::vector<int32_t> q(plane.size());
+            for (int y = 0; y < ht; ++y) {
+                for (int x = 0; x < w; ++x) {
+                    size_t i = static_cast<size_t>(y) * w + x;
+                    float v = plane[i] / step;
+                    q[i] = static_cast<int32_t>(x < llW && y < llH ? std::lround(v) : std::trunc(v));
+                }
+            }
+            coeffs[c] = std::move(q);
+        }
+    });
+
+    ofs.write("WLT ", 4);
+    ofs.write(reinterpret_cast<const char*>(&h.width), sizeof(uint32_t));
+    ofs.write(reinterpret_cast<const char*>(&h.height), sizeof(uint32_t));
+    ofs.put(static_cast<char>(h.channels));
+    ofs.put(static_cast<char>(h.levels));
+    ofs.put(static_cast<char>(h.filter));
+    ofs.put(static_cast<char>(h.quality));
+
+    // 每个分辨率一个数据包：u32 包长 + u32 符号数 + 分块 Huffman 码流，包内按通道、子带顺序排列。
+    std::vector<uint8_t> symbols, packet;
+    for (int r = 0; r <= h.levels; ++r) {
+        Progress::Section section(r, h.levels + 1u);
+        symbols.clear();
+        for (int c = 0; c < h.channels; ++c) {
+            for (const Rect &band : resolutionBands(w, ht, h.levels, r)) appendBand(coeffs[c], w, band, symbols);
+        }
+        packet.clear();
+        VectorStreamBuf pbuf(packet);
+        std::ostream pos(&pbuf);
+        uint32_t symbolCount = static_cast<uint32_t>(symbols.size());
+        pos.write(reinterpret_cast<const char*>(&symbolCount), sizeof(uint32_t));
+        if (symbolCount) Huffman::encodeBlocks(symbols, pos);
+        uint32_t packetSize = static_cast<uint32_t>(packet.size());
+        ofs.write(reinterpret_cast<const char*>(&packetSize), sizeof(uint32_t));
+        ofs.write(reinterpret_cast<const char*>(packet.data()), static_cast<std::streamsize>(packet.size()));
+    }
+}
+
+cv::Mat WaveletCodec::decompress(const std::string &inputPath) {
+    std::vector<uint8_t> buffer = ImageIO::readFile(inputPath);
+    return decompress(buffer.data(), buffer.size());
+}
+
+cv::Mat WaveletCodec::decompress(const uint8_t *data, size_t size) {
+    return decompress(data, size, 0);
+}
+
+cv::Mat WaveletCodec::decompress(std::istream &ifs) {
+    return decompress(ifs, 0);
+}
+
+cv::Mat WaveletCodec::decompress(const uint8_t *data, size_t size, int discardLevels) {
+    SpanStreamBuf buf(data, size);
+    std::istream is(&buf);
+    return decompress(is, discardLevels);
+}
+
+cv::Mat WaveletCodec::decompress(std::istream &ifs, int discardLevels) {
+    MemProfile::Scope memScope("wavelet");
+    char magic[4];
+    ifs.read(magic, 4);
+    if (!ifs || std::string(magic, 4) != "WLT ") throw std::runtime_error("Invalid magic for Wavelet");
+    Header h;
+    ifs.read(reinterpret_cast<char*>(&h.width), sizeof(uint32_t));
+    ifs.read(reinterpret_cast<char*>(&h.height), sizeof(uint32_t));
+    h.channels = static_cast<uint8_t>(ifs.get());
+    h.levels = static_cast<uint8_t>(ifs.get());
+    h.filter = static_cast<uint8_t>(ifs.get());
+    h.quality = static_cast<uint8_t>(ifs.get());
+    if (!ifs || h.width == 0 || h.height == 0 || h.channels == 0 || h.channels > 4 || h.filter > kFilter97 ||
+        h.levels > kMaxLevels) {
+        throw std::runtime_error("Invalid wavelet header");
+    }
+    if (discardLevels < 0) throw std::runtime_error("Discarded levels must be >= 0");
+    int w = static_cast<int>(h.width), ht = static_cast<int>(h.height);
+
+    // 读取分辨率数据包；文件在某个包中间被截断时，停在最后一个完整的分辨率上。
+    // 前 wanted+1 个分辨率的子带都落在第 planned 级 LL 的范围内，系数平面只按该尺寸分配，
+    // 行跨度为 planeW；缩小解码的内存与计算量随输出尺寸下降。
+    int wanted = h.levels - std::min<int>(discardLevels, h.levels);
+    int planned = h.levels - wanted;
+    int planeW = levelSize(w, planned), planeH = levelSize(ht, planned);
+    std::vector<std::vector<int32_t>> coeffs(h.channels, std::vector<int32_t>(static_cast<size_t>(planeW) * planeH, 0));
+    int decoded = -1;
+    std::vector<uint8_t> packet;
+    for (int r = 0; r <= wanted; ++r) {
+        Progress::Section section(r, wanted + 1u);
+        uint32_t packetSize = 0;
+        ifs.read(reinterpret_cast<char*>(&packetSize), sizeof(uint32_t));
+        if (!ifs) break;
+        packet.resize(packetSize);
+        ifs.read(reinterpret_cast<char*>(packet.data()), packetSize);
+        if (!ifs) break;
+        SpanStreamBuf pbuf(packet.data(), packet.size());
+        std::istream pis(&pbuf);
+        uint32_t symbolCount = 0;
+        pis.read(reinterpret_cast<char*>(&symbolCount), sizeof(uint32_t));
+        std::vector<uint8_t> symbols = symbolCount ? Huffman::decodeBlocks(pis, symbolCount) : std::vector<uint8_t>();
+        size_t pos = 0;
+        for (int c = 0; c < h.channels; ++c) {
+            for (const Rect &band : resolutionBands(w, ht, h.levels, r)) readBand(symbols, pos, coeffs[c], planeW, band);
+        }
+        decoded = r;
+    }
+    if (decoded < 0) throw std::runtime_error("Truncated wavelet file: no complete resolution");
+    int skip = h.levels - decoded; // 输出为第 skip 级的 LL，尺寸为原图的 1/2^skip
+    int outW = levelSize(w, skip), outH = levelSize(ht, skip);
+
+    ImageData out;
+    out.width = static_cast<uint32_t>(outW);
+    out.height = static_cast<uint32_t>(outH);
+    out.channels = h.channels;
+    out.channelData.resize(h.channels);
+    float step = stepForQuality(h.quality);
+    Parallel::forEach(h.channels, [&](size_t c) {
+        auto &dst = out.channelData[c];
+        dst.resize(static_cast<size_t>(outW) * outH);
+        if (h.filter == kFilter53) {
+            auto &plane = coeffs[c];
+            for (int l = h.levels - 1; l >= skip; --l) {
+                transform2D(plane, planeW, levelSize(w, l), levelSize(ht, l), false, inverse53);
+            }
+            // 5/3 低通直流增益为 1，各级 LL 本身就是缩小后的图像。
+            for (int y = 0; y < outH; ++y) {
+                for (int x = 0; x < outW; ++x) {
+                    int32_t v = plane[static_cast<size_t>(y) * planeW + x] + 128;
+                    dst[static_cast<size_t>(y) * outW + x] = static_cast<uint8_t>(std::clamp(v, 0, 255));
+                }
+            }
+            return;
+        }
+        const auto &q = coeffs[c];
+        int llW = levelSize(w, h.levels), llH = levelSize(ht, h.levels);
+        // 只反量化实际解码的子带，即第 skip 级 LL 的范围。
+        std::vector<float> plane(q.size());
+        for (int y = 0; y < outH; ++y) {
+            for (int x = 0; x < outW; ++x) {
+                size_t i = static_cast<size_t>(y) * planeW + x;
+                int32_t v = q[i];
+                bool ll = x < llW && y < llH;
+                // 死区量化的重建点取区间中点。
+                plane[i] = ll || v == 0 ? v * step : (v + (v > 0 ? 0.5f : -0.5f)) * step;
+            }
+        }
+        for (int l = h.levels - 1; l >= skip; --l) {
+            transform2D(plane, planeW, levelSize(w, l), levelSize(ht, l), false, inverse97);
+        }
+        // 近似正交归一化下每级 2D 低通的直流增益为 2。
+        float scale = 1.0f / static_cast<float>(1u << skip);
+        for (int y = 0; y < outH; ++y) {
+            for (int x = 0; x < outW; ++x) {
+                float v = plane[static_cast<size_t>(y) * planeW + x] * scale + 128.0f;
+                dst[static_cast<size_t>(y) * outW + x] = static_cast<uint8_t>(std::clamp(std::lround(v), 0L, 255L));
+            }
+        }
+    });
+    return ImageIO::toMat(out);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "ImageData.h"
+
+// Wavelet codec: multi-level 2D lifting transform, per-resolution packets.
+// quality=100 使用可逆整数 5/3 小波（无损）；1-99 使用 9/7 小波并按质量选择量化步长（有损）。
+// 码流按分辨率由低到高排列：LL 之后依次是各级的 HL/LH/HH，
+// 因此丢弃末尾若干分辨率（或文件被截断）仍可解出较低分辨率的图像。
+namespace WaveletCodec {
+constexpr int kDefaultLevels = 5;
+
+void compress(const cv::Mat &img, const std::string &outputPath, int quality);
+void compress(const cv::Mat &img, std::ostream &out, int quality, int levels = kDefaultLevels);
+void compress(const cv::Mat &img, std::vector<uint8_t> &out, int quality);
+cv::Mat decompress(const std::string &inputPath);
+cv::Mat decompress(std::istream &in);
+cv::Mat decompress(const uint8_t *data, size_t size);
+// 只解码到 1/2^discardLevels 分辨率，跳过更高分辨率的数据包；超过分解级数时按级数截断。
+cv::Mat decompress(std::istream &in, int discardLevels);
+cv::Mat decompress(const uint8_t *data, size_t size, int discardLevels);
+}
@@ -0,0 +1,64 @@
+#include "codectask.h"
+#include <QFileInfo>
+#include <chrono>
+#include "../core/ImageData.h"
+#include "../core/Compressor.h"
+#include "../core/Decompressor.h"
+#include "../core/Progress.h"
+
+CodecTask::CodecTask(int id, const Request &request, std::shared_ptr<std::atomic<bool>> cancelFlag)
+    : taskId(id), req(request), cancel(std::move(cancelFlag)) {
+    setAutoDelete(true);
+}
+
+void CodecTask::run() {
+    // 排队期间已被取消的任务直接结束，不再读取文件。
+    if (cancel->load()) {
+        emit cancelled(taskId);
+        return;
+    }
+    emit started(taskId);
+    auto start = std::chrono::steady_clock::now();
+    double totalBytes = 0.0;
+    auto lastEmit = start;
+
+    Progress::Listener listener;
+    listener.cancelFlag = cancel.get();
+    // 回调在工作线程执行；限制发信号频率，避免淹没事件循环。
+    listener.onProgress = [&](double fraction) {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastEmit < std::chrono::milliseconds(50) && fraction < 1.0) return;
+        lastEmit = now;
+        double seconds = std::chrono::duration<double>(now - start).count();
+        double mbps = seconds > 0 ? fraction * totalBytes / seconds / (1024.0 * 1024.0) : 0.0;
+        emit progress(taskId, fraction, mbps);
+    };
+    Progress::Scope scope(listener);
+
+    try {
+        std::string algo = req.algo.toStdString();
+        if (req.compress) {
+            cv::Mat img = ImageIO::loadImage(req.inputPath.toStdString(), false);
+            totalBytes = static_cast<double>(img.total() * img.elemSize());
+            Compressor::compressImage(algo, img, req.outputPath.toStdString(), req.quality);
+            auto end = std::chrono::steady_clock::now();
+            uint64_t compressedSize = QFileInfo(req.outputPath).size();
+            double ratio = compressedSize ? totalBytes / compressedSize : 0.0;
+            emit progress(taskId, 1.0, 0.0);
+            emit finished(taskId, QString("Compression finished. ratio=%1, time(ms)=%2")
+                          .arg(ratio).arg(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()));
+        } else {
+            totalBytes = static_cast<double>(QFileInfo(req.inputPath).size());
+            cv::Mat img = Decompressor::decompressImage(algo, req.inputPath.toStdString());
+            ImageIO::saveImage(req.outputPath.toStdString(), img);
+            auto end = std::chrono::steady_clock::now();
+            emit progress(taskId, 1.0, 0.0);
+            emit finished(taskId, QString("Decompression finished. time(ms)=%1")
+                          .arg(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()));
+        }
+    } catch (const Progress::Cancelled &) {
+        emit cancelled(taskId);
+    } catch (const std::exception &ex) {
+        emit failed(taskId, QString::fromUtf8(ex.what()));
+    }
+}
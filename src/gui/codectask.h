@@ -0,0 +1,35 @@
+#pragma once
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+#include <atomic>
+#include <memory>
+
+// Background compress/decompress job executed on a QThreadPool.
+// 工作线程中运行编解码，通过信号把进度与结果排队送回 UI 线程。
+class CodecTask : public QObject, public QRunnable {
+    Q_OBJECT
+public:
+    struct Request {
+        QString algo;
+        bool compress = true;
+        QString inputPath;
+        QString outputPath;
+        int quality = 75;
+    };
+
+    CodecTask(int id, const Request &request, std::shared_ptr<std::atomic<bool>> cancelFlag);
+    void run() override;
+
+signals:
+    void started(int id);
+    void progress(int id, double fraction, double mbPerSec);
+    void finished(int id, const QString &message);
+    void failed(int id, const QString &message);
+    void cancelled(int id);
+
+private:
+    int taskId;
+    Request req;
+    std::shared_ptr<std::atomic<bool>> cancel;
+};
@@ -0,0 +1,266 @@
+#include "comparedialog.h"
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPixmap>
+#include <QThread>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <set>
+#include "../core/Compressor.h"
+#include "../core/Decompressor.h"
+#include "../core/ImageData.h"
+#include "../core/Metrics.h"
+#include "../core/Progress.h"
+
+namespace {
+enum Column { ColCodec, ColQuality, ColSize, ColRatio, ColEncodeMs, ColDecodeMs, ColEncodeMBps, ColDecodeMBps, ColPSNR, ColCount };
+
+// 按 UserRole 中的数值排序，显示文本可以带单位或写成 "lossless"。
+class NumericItem : public QTableWidgetItem {
+public:
+    NumericItem(const QString &text, double value) : QTableWidgetItem(text) {
+        setData(Qt::UserRole, value);
+        setTextAlignment(Qt::AlignRight);
+    }
+    bool operator<(const QTableWidgetItem &other) const override {
+        return data(Qt::UserRole).toDouble() < other.data(Qt::UserRole).toDouble();
+    }
+};
+
+QImage toQImage(const cv::Mat &img) {
+    if (img.channels() == 1) {
+        return QImage(img.data, img.cols, img.rows, static_cast<int>(img.step), QImage::Format_Grayscale8).copy();
+    }
+    return QImage(img.data, img.cols, img.rows, static_cast<int>(img.step), QImage::Format_RGB888).rgbSwapped();
+}
+
+double mbPerSec(double bytes, double ms) {
+    return ms > 0 ? bytes / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+}
+}
+
+CompareTask::CompareTask(int id, const Entry &e, const cv::Mat &original, std::shared_ptr<std::atomic<bool>> cancelFlag)
+    : taskId(id), entry(e), image(original), cancel(std::move(cancelFlag)) {
+    setAutoDelete(true);
+}
+
+void CompareTask::run() {
+    if (cancel->load()) return;
+    Progress::Listener listener;
+    listener.cancelFlag = cancel.get();
+    Progress::Scope scope(listener);
+    try {
+        std::string algo = entry.algo.toStdString();
+        std::vector<uint8_t> encoded;
+        auto t0 = std::chrono::steady_clock::now();
+        Compressor::compressImage(algo, image, encoded, entry.quality);
+        auto t1 = std::chrono::steady_clock::now();
+        cv::Mat decoded = Decompressor::decompressImage(algo, encoded.data(), encoded.size());
+        auto t2 = std::chrono::steady_clock::now();
+
+        // DCT 只编码灰度，PSNR 与原图的灰度版本比较。
+        cv::Mat reference = image;
+        if (decoded.channels() == 1 && image.channels() == 3) cv::cvtColor(image, reference, cv::COLOR_BGR2GRAY);
+        double psnr = Metrics::psnr(reference, decoded);
+        QImage preview = entry.lossy ? toQImage(decoded) : QImage();
+        emit finished(taskId, static_cast<qint64>(encoded.size()),
+                      std::chrono::duration<double, std::milli>(t1 - t0).count(),
+                      std::chrono::duration<double, std::milli>(t2 - t1).count(), psnr, preview);
+    } catch (const Progress::Cancelled &) {
+        // 对话框关闭时取消，不再回报结果。
+    } catch (const std::exception &ex) {
+        emit failed(taskId, QString::fromUtf8(ex.what()));
+    }
+}
+
+CompareDialog::CompareDialog(const QString &imagePath, int defaultQuality, QWidget *parent)
+    : QDialog(parent), path(imagePath), cancel(std::make_shared<std::atomic<bool>>(false)) {
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    QHBoxLayout *controls = new QHBoxLayout();
+    controls->addWidget(new QLabel("Lossy qualities:"));
+    qualityEdit = new QLineEdit();
+    QStringList qualities;
+    for (int q : std::set<int>{30, 50, std::min(defaultQuality, 99), 90}) qualities.append(QString::number(q));
+    qualityEdit->setText(qualities.join(","));
+    qualityEdit->setToolTip("Comma-separated qualities for DCT and lossy wavelet");
+    controls->addWidget(qualityEdit, 1);
+    startBtn = new QPushButton("Start");
+    connect(startBtn, &QPushButton::clicked, this, &CompareDialog::onStart);
+    controls->addWidget(startBtn);
+    layout->addLayout(controls);
+
+    QHBoxLayout *body = new QHBoxLayout();
+    table = new QTableWidget(0, ColCount);
+    table->setHorizontalHeaderLabels({"Codec", "Quality", "Size (KB)", "Ratio", "Encode (ms)", "Decode (ms)",
+                                      "Encode MB/s", "Decode MB/s", "PSNR (dB)"});
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSelectionMode(QAbstractItemView::SingleSelection);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    connect(table, &QTableWidget::itemSelectionChanged, this, &CompareDialog::onSelectionChanged);
+    body->addWidget(table, 3);
+    previewLabel = new QLabel("Select a lossy result to preview it.");
+    previewLabel->setAlignment(Qt::AlignCenter);
+    previewLabel->setMinimumSize(320, 240);
+    body->addWidget(previewLabel, 2);
+    layout->addLayout(body, 1);
+
+    statusLabel = new QLabel("Idle");
+    layout->addWidget(statusLabel);
+
+    setWindowTitle("Compare codecs - " + QFileInfo(path).fileName());
+    resize(1100, 520);
+    pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+}
+
+CompareDialog::~CompareDialog() {
+    // 与主窗口一致：关闭时取消剩余任务并等待工作线程退出。
+    cancel->store(true);
+    pool.waitForDone();
+}
+
+void CompareDialog::onStart() {
+    cv::Mat img;
+    try {
+        img = ImageIO::loadImage(path.toStdString(), false);
+    } catch (const std::exception &ex) {
+        QMessageBox::critical(this, "Error", QString::fromUtf8(ex.what()));
+        return;
+    }
+    std::vector<int> qualities;
+    for (const QString &part : qualityEdit->text().split(",")) {
+        bool ok = false;
+        int q = part.trimmed().toInt(&ok);
+        if (!ok || q < 1 || q > 99) {
+            QMessageBox::warning(this, "Validation", "Qualities must be comma-separated integers in 1-99.");
+            return;
+        }
+        qualities.push_back(q);
+    }
+
+    // 无损算法各跑一次，DCT 与有损小波按每个质量各跑一次。
+    std::vector<CompareTask::Entry> entries;
+    for (const char *algo : {"huffman", "rle", "lzw", "lz77"}) entries.push_back({algo, 75, false});
+    entries.push_back({"wavelet", 100, false});
+    for (int q : qualities) {
+        entries.push_back({"dct", q, true});
+        entries.push_back({"wavelet", q, true});
+    }
+
+    // 上一轮未完成的任务先取消，新一轮使用新的取消标志。
+    cancel->store(true);
+    pool.waitForDone();
+    cancel = std::make_shared<std::atomic<bool>>(false);
+    // 取消前已排队的 finished/failed 信号仍可能在新行建立后送达，按轮次号过滤。
+    const int gen = ++generation;
+    previews.clear();
+    previewLabel->clear();
+    previewLabel->setText("Select a lossy result to preview it.");
+    rawBytes = static_cast<double>(img.total() * img.elemSize());
+
+    table->setSortingEnabled(false);
+    table->clearContents();
+    table->setRowCount(static_cast<int>(entries.size()));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto &e = entries[i];
+        int id = static_cast<int>(i);
+        QString name = e.algo;
+        if (e.algo == "dct" && img.channels() == 3) name += " (grey)";
+        QTableWidgetItem *codecItem = new QTableWidgetItem(name);
+        codecItem->setData(Qt::UserRole, id);
+        table->setItem(id, ColCodec, codecItem);
+        table->setItem(id, ColQuality, new NumericItem(e.lossy ? QString::number(e.quality) : QString("lossless"),
+                                                         e.lossy ? e.quality : 101));
+        table->setItem(id, ColSize, new QTableWidgetItem("queued"));
+
+        CompareTask *task = new CompareTask(id, e, img, cancel);
+        connect(task, &CompareTask::finished, this,
+                [this, gen](int taskId, qint64 bytes, double encodeMs, double decodeMs, double psnr, const QImage &preview) {
+            if (gen != generation) return;
+            if (!preview.isNull()) previews.insert(taskId, preview);
+            setResult(taskId, bytes, encodeMs, decodeMs, psnr);
+        }, Qt::QueuedConnection);
+        connect(task, &CompareTask::failed, this, [this, gen](int taskId, const QString &msg) {
+            if (gen != generation) return;
+            setFailed(taskId, msg);
+        }, Qt::QueuedConnection);
+        pool.start(task);
+    }
+    table->setSortingEnabled(true);
+    total = pending = static_cast<int>(entries.size());
+    startBtn->setEnabled(false);
+    updateStatus();
+}
+
+int CompareDialog::findRow(int id) const {
+    // 排序后行号会变化，按编解码器列中保存的任务 ID 查找。
+    for (int row = 0; row < table->rowCount(); ++row) {
+        QTableWidgetItem *item = table->item(row, ColCodec);
+        if (item && item->data(Qt::UserRole).toInt() == id) return row;
+    }
+    return -1;
+}
+
+void CompareDialog::setResult(int id, qint64 bytes, double encodeMs, double decodeMs, double psnr) {
+    int row = findRow(id);
+    if (row < 0) return;
+    double ratio = bytes ? rawBytes / bytes : 0.0;
+    double encodeRate = mbPerSec(rawBytes, encodeMs), decodeRate = mbPerSec(rawBytes, decodeMs);
+    bool lossless = std::isinf(psnr);
+    // 写入期间关闭排序，避免行在逐列赋值时移动。
+    table->setSortingEnabled(false);
+    table->setItem(row, ColSize, new NumericItem(QString::number(bytes / 1024.0, 'f', 1), static_cast<double>(bytes)));
+    table->setItem(row, ColRatio, new NumericItem(QString::number(ratio, 'f', 2), ratio));
+    table->setItem(row, ColEncodeMs, new NumericItem(QString::number(encodeMs, 'f', 1), encodeMs));
+    table->setItem(row, ColDecodeMs, new NumericItem(QString::number(decodeMs, 'f', 1), decodeMs));
+    table->setItem(row, ColEncodeMBps, new NumericItem(QString::number(encodeRate, 'f', 1), encodeRate));
+    table->setItem(row, ColDecodeMBps, new NumericItem(QString::number(decodeRate, 'f', 1), decodeRate));
+    table->setItem(row, ColPSNR, new NumericItem(lossless ? QString("lossless") : QString::number(psnr, 'f', 2),
+                                                 lossless ? std::numeric_limits<double>::max() : psnr));
+    table->setSortingEnabled(true);
+    --pending;
+    updateStatus();
+    onSelectionChanged();
+}
+
+void CompareDialog::setFailed(int id, const QString &message) {
+    int row = findRow(id);
+    if (row >= 0) {
+        table->setSortingEnabled(false);
+        QTableWidgetItem *item = new QTableWidgetItem("error");
+        item->setToolTip(message);
+        table->setItem(row, ColSize, item);
+        table->setSortingEnabled(true);
+    }
+    --pending;
+    updateStatus();
+}
+
+void CompareDialog::onSelectionChanged() {
+    int row = table->currentRow();
+    QTableWidgetItem *item = row >= 0 ? table->item(row, ColCodec) : nullptr;
+    if (!item) return;
+    int id = item->data(Qt::UserRole).toInt();
+    if (!previews.contains(id)) {
+        previewLabel->clear();
+        previewLabel->setText("No preview (lossless or still running).");
+        return;
+    }
+    QPixmap pixmap = QPixmap::fromImage(previews.value(id));
+    previewLabel->setPixmap(pixmap.scaled(previewLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+}
+
+void CompareDialog::updateStatus() {
+    if (pending > 0) {
+        statusLabel->setText(QString("%1 of %2 runs done, %3 threads").arg(total - pending).arg(total).arg(pool.maxThreadCount()));
+    } else {
+        statusLabel->setText(QString("All %1 runs done. Click a column header to sort.").arg(total));
+        startBtn->setEnabled(true);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <QDialog>
+#include <QImage>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMap>
+#include <QPushButton>
+#include <QRunnable>
+#include <QTableWidget>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include <opencv2/opencv.hpp>
+
+// One codec/quality measurement run on a worker thread: encode to memory,
+// decode back, then time both and compute PSNR against the original.
+// 原图 cv::Mat 在各任务间只读共享，不复制像素。
+class CompareTask : public QObject, public QRunnable {
+    Q_OBJECT
+public:
+    struct Entry {
+        QString algo;
+        int quality = 75;
+        bool lossy = false;
+    };
+
+    CompareTask(int id, const Entry &entry, const cv::Mat &original, std::shared_ptr<std::atomic<bool>> cancelFlag);
+    void run() override;
+
+signals:
+    // psnr 为 +inf 表示无损；preview 仅对有损条目非空。
+    void finished(int id, qint64 bytes, double encodeMs, double decodeMs, double psnr, const QImage &preview);
+    void failed(int id, const QString &message);
+
+private:
+    int taskId;
+    Entry entry;
+    cv::Mat image;
+    std::shared_ptr<std::atomic<bool>> cancel;
+};
+
+// Runs every codec (DCT and lossy wavelet at several qualities) on one image
+// concurrently and lists size, ratio, timing, throughput and PSNR in a sortable
+// table. 选中有损结果的行时在右侧显示解码预览。
+class CompareDialog : public QDialog {
+    Q_OBJECT
+public:
+    CompareDialog(const QString &imagePath, int defaultQuality, QWidget *parent = nullptr);
+    ~CompareDialog() override;
+
+private slots:
+    void onStart();
+    void onSelectionChanged();
+
+private:
+    QString path;
+    QLineEdit *qualityEdit;
+    QPushButton *startBtn;
+    QTableWidget *table;
+    QLabel *previewLabel;
+    QLabel *statusLabel;
+    QThreadPool pool;
+    std::shared_ptr<std::atomic<bool>> cancel;
+    QMap<int, QImage> previews;
+    double rawBytes = 0.0;
+    int pending = 0;
+    int total = 0;
+    int generation = 0; // 每次 Start 递增，丢弃上一轮迟到的结果信号
+    int findRow(int id) const;
+    void setResult(int id, qint64 bytes, double encodeMs, double decodeMs, double psnr);
+    void setFailed(int id, const QString &message);
+    void updateStatus();
+};
@@ -6,11 +6,10 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QDateTime>
-#include <QFileInfo>
-#include <chrono>
-#include "../core/ImageData.h"
-#include "../core/Compressor.h"
-#include "../core/Decompressor.h"
+#include <QThread>
+#include <algorithm>
+#include "codectask.h"
+#include "comparedialog.h"
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     QWidget *central = new QWidget(this);
@@ -34,7 +33,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     QHBoxLayout *algoRow = new QHBoxLayout();
     algoRow->addWidget(new QLabel("Algorithm:"));
     algoCombo = new QComboBox();
-    algoCombo->addItems({"Huffman", "RLE", "LZW", "Lossy DCT"});
+    algoCombo->addItems({"Huffman", "RLE", "LZW", "Lossy DCT", "Wavelet", "LZ77"});
     connect(algoCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onAlgorithmChanged);
     algoRow->addWidget(algoCombo);
 
@@ -52,9 +51,29 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     qRow->addWidget(qualitySpin);
     layout->addLayout(qRow);
 
+    QHBoxLayout *runRow = new QHBoxLayout();
     QPushButton *runBtn = new QPushButton("Run");
     connect(runBtn, &QPushButton::clicked, this, &MainWindow::onRun);
-    layout->addWidget(runBtn);
+    runRow->addWidget(runBtn);
+    cancelBtn = new QPushButton("Cancel");
+    cancelBtn->setEnabled(false);
+    connect(cancelBtn, &QPushButton::clicked, this, &MainWindow::onCancel);
+    runRow->addWidget(cancelBtn);
+    QPushButton *compareBtn = new QPushButton("Compare codecs...");
+    connect(compareBtn, &QPushButton::clicked, this, &MainWindow::onCompare);
+    runRow->addWidget(compareBtn);
+    layout->addLayout(runRow);
+
+    QHBoxLayout *progressRow = new QHBoxLayout();
+    progressBar = new QProgressBar();
+    progressBar->setRange(0, 1000);
+    progressBar->setValue(0);
+    progressBar->setTextVisible(false);
+    progressRow->addWidget(progressBar, 1);
+    statusLabel = new QLabel("Idle");
+    statusLabel->setMinimumWidth(220);
+    progressRow->addWidget(statusLabel);
+    layout->addLayout(progressRow);
 
     logView = new QPlainTextEdit();
     logView->setReadOnly(true);
@@ -63,6 +82,15 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     setCentralWidget(central);
     setWindowTitle("Image Compression Tool");
     onAlgorithmChanged(0);
+
+    // 所有 Run 共享同一个线程池，排队执行而不阻塞事件循环。
+    pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+}
+
+MainWindow::~MainWindow() {
+    // 关闭窗口时取消仍在排队或运行的任务，并等待工作线程退出后再析构控件。
+    for (auto &run : runs) run.cancel->store(true);
+    pool.waitForDone();
 }
 
 void MainWindow::logMessage(const QString &msg) {
@@ -74,7 +102,7 @@ void MainWindow::browseInput() {
     if (modeCombo->currentIndex() == 0) {
         path = QFileDialog::getOpenFileName(this, "Open Image", QString(), "Images (*.png *.bmp *.jpg *.jpeg)");
     } else {
-        path = QFileDialog::getOpenFileName(this, "Open Compressed", QString(), "Compressed (*.huf *.rle *.lzw *.dct *.*)");
+        path = QFileDialog::getOpenFileName(this, "Open Compressed", QString(), "Compressed (*.huf *.rle *.lzw *.dct *.wlt *.lz77 *.*)");
     }
     if (!path.isEmpty()) inputEdit->setText(path);
 }
@@ -85,8 +113,9 @@ void MainWindow::browseOutput() {
 }
 
 void MainWindow::onAlgorithmChanged(int index) {
-    bool isDct = (index == 3);
-    qualitySpin->setEnabled(isDct);
+    // DCT 与小波使用质量参数；小波质量 100 为无损。
+    bool usesQuality = (index == 3 || index == 4);
+    qualitySpin->setEnabled(usesQuality);
 }
 
 void MainWindow::onRun() {
@@ -94,35 +123,99 @@ void MainWindow::onRun() {
         QMessageBox::warning(this, "Validation", "Please select input and output files.");
         return;
     }
-    std::string algo;
+    CodecTask::Request request;
     switch (algoCombo->currentIndex()) {
-        case 0: algo = "huffman"; break;
-        case 1: algo = "rle"; break;
-        case 2: algo = "lzw"; break;
-        case 3: algo = "dct"; break;
+        case 0: request.algo = "huffman"; break;
+        case 1: request.algo = "rle"; break;
+        case 2: request.algo = "lzw"; break;
+        case 3: request.algo = "dct"; break;
+        case 4: request.algo = "wavelet"; break;
+        case 5: request.algo = "lz77"; break;
+    }
+    request.compress = modeCombo->currentIndex() == 0;
+    request.inputPath = inputEdit->text();
+    request.outputPath = outputEdit->text();
+    request.quality = qualitySpin->value();
+
+    int id = nextRunId++;
+    RunState state;
+    QString modeName = request.compress ? QString("compress") : QString("decompress");
+    state.name = QString("#%1 %2 %3").arg(id).arg(request.algo, modeName);
+    state.cancel = std::make_shared<std::atomic<bool>>(false);
+    runs.insert(id, state);
+
+    // 任务对象在工作线程中发信号，跨线程连接自动排队回到 UI 线程。
+    CodecTask *task = new CodecTask(id, request, state.cancel);
+    connect(task, &CodecTask::started, this, [this](int runId) {
+        if (runs.contains(runId)) runs[runId].running = true;
+        updateProgressView();
+    }, Qt::QueuedConnection);
+    connect(task, &CodecTask::progress, this, [this](int runId, double fraction, double mbps) {
+        if (!runs.contains(runId)) return;
+        runs[runId].fraction = fraction;
+        runs[runId].mbPerSec = mbps;
+        updateProgressView();
+    }, Qt::QueuedConnection);
+    connect(task, &CodecTask::finished, this, [this](int runId, const QString &msg) {
+        logMessage(runs.value(runId).name + ": " + msg);
+        finishRun(runId);
+    }, Qt::QueuedConnection);
+    connect(task, &CodecTask::failed, this, [this](int runId, const QString &msg) {
+        QString name = runs.value(runId).name;
+        logMessage(QString("%1: Error: %2").arg(name, msg));
+        finishRun(runId);
+        QMessageBox::critical(this, "Error", msg);
+    }, Qt::QueuedConnection);
+    connect(task, &CodecTask::cancelled, this, [this](int runId) {
+        logMessage(runs.value(runId).name + ": cancelled.");
+        finishRun(runId);
+    }, Qt::QueuedConnection);
+
+    logMessage(state.name + ": queued.");
+    pool.start(task);
+    updateProgressView();
+}
+
+void MainWindow::onCompare() {
+    if (modeCombo->currentIndex() != 0 || inputEdit->text().isEmpty()) {
+        QMessageBox::warning(this, "Validation", "Select an input image in Compress mode to compare codecs.");
+        return;
+    }
+    // 非模态对话框，使用自己的线程池，关闭时自动释放。
+    CompareDialog *dialog = new CompareDialog(inputEdit->text(), qualitySpin->value(), this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::onCancel() {
+    // 取消所有排队与运行中的任务；运行中的任务在下一次进度回调时退出。
+    for (auto &run : runs) run.cancel->store(true);
+    logMessage("Cancelling active runs...");
+}
+
+void MainWindow::finishRun(int id) {
+    runs.remove(id);
+    updateProgressView();
+}
+
+void MainWindow::updateProgressView() {
+    cancelBtn->setEnabled(!runs.isEmpty());
+    if (runs.isEmpty()) {
+        progressBar->setValue(0);
+        statusLabel->setText("Idle");
+        return;
     }
-    bool compress = modeCombo->currentIndex() == 0;
-    try {
-        auto start = std::chrono::steady_clock::now();
-        if (compress) {
-            cv::Mat img = ImageIO::loadImage(inputEdit->text().toStdString(), false);
-            Compressor::compressImage(algo, img, outputEdit->text().toStdString(), qualitySpin->value());
-            auto end = std::chrono::steady_clock::now();
-            auto originalSize = static_cast<uint64_t>(img.total() * img.elemSize());
-            uint64_t compressedSize = QFileInfo(outputEdit->text()).size();
-            double ratio = compressedSize ? static_cast<double>(originalSize) / compressedSize : 0.0;
-            logMessage(QString("Compression finished. ratio=%1, time(ms)=%2")
-                       .arg(ratio).arg(std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count()));
-        } else {
-            cv::Mat img = Decompressor::decompressImage(algo, inputEdit->text().toStdString());
-            ImageIO::saveImage(outputEdit->text().toStdString(), img);
-            auto end = std::chrono::steady_clock::now();
-            logMessage(QString("Decompression finished. time(ms)=%1")
-                       .arg(std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count()));
+    // 多个任务并发时显示平均进度与总吞吐量。
+    int running = 0;
+    double fractionSum = 0.0, mbpsSum = 0.0;
+    for (const auto &run : runs) {
+        fractionSum += run.fraction;
+        if (run.running) {
+            ++running;
+            mbpsSum += run.mbPerSec;
         }
-        QMessageBox::information(this, "Done", "Operation completed.");
-    } catch (const std::exception &ex) {
-        logMessage(QString("Error: %1").arg(ex.what()));
-        QMessageBox::critical(this, "Error", ex.what());
     }
+    progressBar->setValue(static_cast<int>(fractionSum / runs.size() * 1000.0));
+    statusLabel->setText(QString("%1 running, %2 queued, %3 MB/s")
+                         .arg(running).arg(runs.size() - running).arg(mbpsSum, 0, 'f', 1));
 }
@@ -5,24 +5,50 @@
 #include <QPushButton>
 #include <QPlainTextEdit>
 #include <QSpinBox>
+#include <QProgressBar>
+#include <QLabel>
+#include <QThreadPool>
+#include <QMap>
+#include <atomic>
+#include <memory>
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
 public:
     explicit MainWindow(QWidget *parent = nullptr);
+    ~MainWindow() override;
 
 private slots:
     void browseInput();
     void browseOutput();
     void onRun();
+    void onCancel();
     void onAlgorithmChanged(int index);
+    void onCompare();
 
 private:
+    // 每次 Run 对应一个后台任务，记录其进度与取消标志。
+    struct RunState {
+        QString name;
+        bool running = false;
+        double fraction = 0.0;
+        double mbPerSec = 0.0;
+        std::shared_ptr<std::atomic<bool>> cancel;
+    };
+
     QLineEdit *inputEdit;
     QLineEdit *outputEdit;
     QComboBox *algoCombo;
     QComboBox *modeCombo;
     QSpinBox *qualitySpin;
+    QProgressBar *progressBar;
+    QLabel *statusLabel;
+    QPushButton *cancelBtn;
     QPlainTextEdit *logView;
+    QThreadPool pool;
+    QMap<int, RunState> runs;
+    int nextRunId = 1;
     void logMessage(const QString &msg);
+    void finishRun(int id);
+    void updateProgressView();
 };
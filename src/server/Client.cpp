@@ -0,0 +1,98 @@
+#include "Client.h"
+#include <filesystem>
+#include <stdexcept>
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+std::string absolutePath(const std::string &path) {
+    return std::filesystem::absolute(path).string();
+}
+}
+
+#ifdef _WIN32
+Client::Client(const std::string &) {
+    throw std::runtime_error("client mode requires Unix domain sockets, which this platform does not support");
+}
+
+Client::~Client() = default;
+#else
+Client::Client(const std::string &socketPath) {
+    sockaddr_un addr{};
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Invalid socket path: " + socketPath);
+    }
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error(std::string("socket() failed: ") + std::strerror(errno));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::string err = std::strerror(errno);
+        ::close(fd);
+        throw std::runtime_error("Cannot connect to " + socketPath + ": " + err);
+    }
+}
+
+Client::~Client() {
+    if (fd >= 0) ::close(fd);
+}
+#endif
+
+std::vector<uint8_t> Client::call(const Protocol::Request &req) {
+    Protocol::encodeRequest(req, frame);
+    Protocol::writeAll(fd, frame);
+    if (!Protocol::readFrame(fd, frame)) throw std::runtime_error("Server closed the connection");
+    Protocol::Response resp = Protocol::decodeResponse(frame);
+    if (!resp.ok) throw std::runtime_error(resp.error);
+    return std::move(resp.data);
+}
+
+void Client::compressFile(const std::string &algo, const std::string &input, const std::string &output, int quality) {
+    Protocol::Request req;
+    req.op = Protocol::Op::Compress;
+    req.quality = static_cast<uint8_t>(quality);
+    req.algo = algo;
+    req.inputPath = absolutePath(input);
+    req.outputPath = absolutePath(output);
+    call(req);
+}
+
+void Client::decompressFile(const std::string &algo, const std::string &input, const std::string &output) {
+    Protocol::Request req;
+    req.op = Protocol::Op::Decompress;
+    req.algo = algo;
+    req.inputPath = absolutePath(input);
+    req.outputPath = absolutePath(output);
+    call(req);
+}
+
+std::vector<uint8_t> Client::compress(const std::string &algo, const cv::Mat &img, int quality) {
+    Protocol::Request req;
+    req.op = Protocol::Op::Compress;
+    req.flags = Protocol::kInlineInput | Protocol::kInlineOutput;
+    req.quality = static_cast<uint8_t>(quality);
+    req.algo = algo;
+    Protocol::appendImage(img, req.data);
+    return call(req);
+}
+
+cv::Mat Client::decompress(const std::string &algo, const std::vector<uint8_t> &data) {
+    Protocol::Request req;
+    req.op = Protocol::Op::Decompress;
+    req.flags = Protocol::kInlineInput | Protocol::kInlineOutput;
+    req.algo = algo;
+    req.data = data;
+    std::vector<uint8_t> result = call(req);
+    return Protocol::parseImage(result.data(), result.size());
+}
+
+Protocol::ServerStats Client::stats() {
+    Protocol::Request req;
+    req.op = Protocol::Op::Stats;
+    return Protocol::parseStats(call(req));
+}
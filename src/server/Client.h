@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "Protocol.h"
+
+// Synchronous client for the serve daemon; one connection, one request in flight.
+// 路径型请求由守护进程直接读写文件，路径会先转换为绝对路径；内联请求通过 socket 传输数据。
+class Client {
+public:
+    explicit Client(const std::string &socketPath);
+    ~Client();
+    Client(const Client &) = delete;
+    Client &operator=(const Client &) = delete;
+
+    void compressFile(const std::string &algo, const std::string &input, const std::string &output, int quality = 75);
+    void decompressFile(const std::string &algo, const std::string &input, const std::string &output);
+    std::vector<uint8_t> compress(const std::string &algo, const cv::Mat &img, int quality = 75);
+    cv::Mat decompress(const std::string &algo, const std::vector<uint8_t> &data);
+    Protocol::ServerStats stats();
+
+private:
+    // 发送请求并等待响应；服务端返回错误时抛出 runtime_error。
+    std::vector<uint8_t> call(const Protocol::Request &req);
+
+    int fd = -1;
+    std::vector<uint8_t> frame;
+};
@@ -0,0 +1,240 @@
+#include "Protocol.h"
+#include <cstring>
+#include <stdexcept>
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+void putU16(std::vector<uint8_t> &out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void putU32(std::vector<uint8_t> &out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+void putU64(std::vector<uint8_t> &out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+void putString(std::vector<uint8_t> &out, const std::string &s) {
+    if (s.size() > 0xFFFF) throw std::runtime_error("Protocol string too long");
+    putU16(out, static_cast<uint16_t>(s.size()));
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+// 预留 4 字节长度前缀，负载写完后由 finishFrame 回填。
+void beginFrame(std::vector<uint8_t> &frame) {
+    frame.clear();
+    frame.resize(4);
+}
+
+void finishFrame(std::vector<uint8_t> &frame) {
+    uint32_t size = static_cast<uint32_t>(frame.size() - 4);
+    for (int i = 0; i < 4; ++i) frame[i] = static_cast<uint8_t>(size >> (8 * i));
+}
+
+class Reader {
+public:
+    Reader(const uint8_t *d, size_t n) : data(d), size(n) {}
+    uint64_t take(int bytes) {
+        need(static_cast<size_t>(bytes));
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; ++i) v |= static_cast<uint64_t>(data[pos++]) << (8 * i);
+        return v;
+    }
+    std::string string() {
+        size_t len = static_cast<size_t>(take(2));
+        need(len);
+        std::string s(reinterpret_cast<const char*>(data + pos), len);
+        pos += len;
+        return s;
+    }
+    const uint8_t *rest() const { return data + pos; }
+    size_t remaining() const { return size - pos; }
+private:
+    void need(size_t n) const {
+        if (size - pos < n) throw std::runtime_error("Truncated protocol message");
+    }
+    const uint8_t *data;
+    size_t size;
+    size_t pos = 0;
+};
+}
+
+void Protocol::encodeRequest(const Request &req, std::vector<uint8_t> &frame) {
+    beginFrame(frame);
+    frame.push_back(static_cast<uint8_t>(req.op));
+    frame.push_back(req.flags);
+    frame.push_back(req.quality);
+    frame.push_back(0);
+    putString(frame, req.algo);
+    putString(frame, req.inputPath);
+    putString(frame, req.outputPath);
+    frame.insert(frame.end(), req.data.begin(), req.data.end());
+    finishFrame(frame);
+}
+
+void Protocol::encodeResponse(const Response &resp, std::vector<uint8_t> &frame) {
+    beginFrame(frame);
+    frame.push_back(resp.ok ? 0 : 1);
+    frame.push_back(0); frame.push_back(0); frame.push_back(0);
+    if (resp.ok) {
+        frame.insert(frame.end(), resp.data.begin(), resp.data.end());
+    } else {
+        frame.insert(frame.end(), resp.error.begin(), resp.error.end());
+    }
+    finishFrame(frame);
+}
+
+Protocol::Request Protocol::decodeRequest(const std::vector<uint8_t> &payload) {
+    Reader r(payload.data(), payload.size());
+    Request req;
+    uint8_t op = static_cast<uint8_t>(r.take(1));
+    if (op < static_cast<uint8_t>(Op::Compress) || op > static_cast<uint8_t>(Op::Stats)) {
+        throw std::runtime_error("Unknown request op");
+    }
+    req.op = static_cast<Op>(op);
+    req.flags = static_cast<uint8_t>(r.take(1));
+    req.quality = static_cast<uint8_t>(r.take(1));
+    r.take(1);
+    req.algo = r.string();
+    req.inputPath = r.string();
+    req.outputPath = r.string();
+    req.data.assign(r.rest(), r.rest() + r.remaining());
+    return req;
+}
+
+Protocol::Response Protocol::decodeResponse(const std::vector<uint8_t> &payload) {
+    Reader r(payload.data(), payload.size());
+    Response resp;
+    resp.ok = r.take(1) == 0;
+    r.take(3);
+    if (resp.ok) {
+        resp.data.assign(r.rest(), r.rest() + r.remaining());
+    } else {
+        resp.error.assign(reinterpret_cast<const char*>(r.rest()), r.remaining());
+    }
+    return resp;
+}
+
+void Protocol::appendImage(const cv::Mat &img, std::vector<uint8_t> &out) {
+    cv::Mat continuous = img.isContinuous() ? img : img.clone();
+    putU32(out, static_cast<uint32_t>(continuous.rows));
+    putU32(out, static_cast<uint32_t>(continuous.cols));
+    putU32(out, static_cast<uint32_t>(continuous.type()));
+    const uint8_t *pixels = continuous.ptr<uint8_t>(0);
+    out.insert(out.end(), pixels, pixels + continuous.total() * continuous.elemSize());
+}
+
+cv::Mat Protocol::parseImage(const uint8_t *data, size_t size) {
+    Reader r(data, size);
+    int rows = static_cast<int>(r.take(4));
+    int cols = static_cast<int>(r.take(4));
+    int type = static_cast<int>(r.take(4));
+    if (rows <= 0 || cols <= 0 || CV_MAT_DEPTH(type) != CV_8U || CV_MAT_CN(type) > 4) {
+        throw std::runtime_error("Invalid inline image header");
+    }
+    cv::Mat img(rows, cols, type);
+    size_t bytes = img.total() * img.elemSize();
+    if (r.remaining() != bytes) throw std::runtime_error("Inline image size mismatch");
+    std::memcpy(img.ptr<uint8_t>(0), r.rest(), bytes);
+    return img;
+}
+
+void Protocol::appendStats(const ServerStats &stats, std::vector<uint8_t> &out) {
+    putU64(out, stats.uptimeMs);
+    putU64(out, stats.connections);
+    putU64(out, stats.activeConnections);
+    for (const OpStats &op : stats.ops) {
+        putU64(out, op.count);
+        putU64(out, op.errors);
+        putU64(out, op.p50Us);
+        putU64(out, op.p90Us);
+        putU64(out, op.p99Us);
+        putU64(out, op.maxUs);
+    }
+    putU64(out, stats.cache.hits);
+    putU64(out, stats.cache.misses);
+    putU64(out, stats.cache.evictions);
+    putU64(out, stats.cache.uncacheable);
+    putU64(out, stats.cache.entries);
+    putU64(out, stats.cache.bytes);
+    putU64(out, stats.cache.byteBudget);
+}
+
+Protocol::ServerStats Protocol::parseStats(const std::vector<uint8_t> &data) {
+    Reader r(data.data(), data.size());
+    ServerStats stats;
+    stats.uptimeMs = r.take(8);
+    stats.connections = r.take(8);
+    stats.activeConnections = r.take(8);
+    for (OpStats &op : stats.ops) {
+        op.count = r.take(8);
+        op.errors = r.take(8);
+        op.p50Us = r.take(8);
+        op.p90Us = r.take(8);
+        op.p99Us = r.take(8);
+        op.maxUs = r.take(8);
+    }
+    stats.cache.hits = r.take(8);
+    stats.cache.misses = r.take(8);
+    stats.cache.evictions = r.take(8);
+    stats.cache.uncacheable = r.take(8);
+    stats.cache.entries = static_cast<size_t>(r.take(8));
+    stats.cache.bytes = static_cast<size_t>(r.take(8));
+    stats.cache.byteBudget = static_cast<size_t>(r.take(8));
+    return stats;
+}
+
+#ifdef _WIN32
+bool Protocol::readFrame(int, std::vector<uint8_t> &) {
+    throw std::runtime_error("Unix domain sockets are not supported on this platform");
+}
+
+void Protocol::writeAll(int, const std::vector<uint8_t> &) {
+    throw std::runtime_error("Unix domain sockets are not supported on this platform");
+}
+#else
+namespace {
+// 读满 size 字节；在第一个字节之前遇到 EOF 返回 false。
+bool readExact(int fd, uint8_t *dst, size_t size) {
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = ::read(fd, dst + got, size - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) throw std::runtime_error(std::string("Socket read failed: ") + std::strerror(errno));
+        if (n == 0) {
+            if (got == 0) return false;
+            throw std::runtime_error("Connection closed mid-frame");
+        }
+        got += static_cast<size_t>(n);
+    }
+    return true;
+}
+}
+
+bool Protocol::readFrame(int fd, std::vector<uint8_t> &payload) {
+    uint8_t header[4];
+    if (!readExact(fd, header, 4)) return false;
+    uint32_t size = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<uint32_t>(header[3]) << 24);
+    if (size > kMaxFrame) throw std::runtime_error("Frame too large");
+    payload.resize(size);
+    if (size && !readExact(fd, payload.data(), size)) throw std::runtime_error("Connection closed mid-frame");
+    return true;
+}
+
+void Protocol::writeAll(int fd, const std::vector<uint8_t> &frame) {
+    size_t sent = 0;
+    while (sent < frame.size()) {
+        ssize_t n = ::send(fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) throw std::runtime_error(std::string("Socket write failed: ") + std::strerror(errno));
+        sent += static_cast<size_t>(n);
+    }
+}
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "core/ImageCache.h"
+
+// Framed request/response protocol spoken over the serve daemon's Unix socket.
+// 每帧为 u32 负载长度（小端）+ 负载。请求负载：
+//   u8 op, u8 flags, u8 quality, u8 reserved,
+//   u16 长度 + 算法名, u16 长度 + 输入路径, u16 长度 + 输出路径, 其余字节为内联输入数据。
+// 响应负载：u8 status(0 成功/1 失败), 3 字节保留, 其余为结果数据或错误信息。
+// 内联图像统一为 i32 rows, i32 cols, i32 type + 连续像素。
+namespace Protocol {
+enum class Op : uint8_t { Compress = 1, Decompress = 2, Stats = 3 };
+
+constexpr uint8_t kInlineInput = 1;  // 输入取自请求数据而非 inputPath
+constexpr uint8_t kInlineOutput = 2; // 结果随响应返回而非写入 outputPath
+constexpr uint32_t kMaxFrame = 1u << 30;
+
+struct Request {
+    Op op = Op::Stats;
+    uint8_t flags = 0;
+    uint8_t quality = 75;
+    std::string algo;
+    std::string inputPath;
+    std::string outputPath;
+    std::vector<uint8_t> data;
+};
+
+struct Response {
+    bool ok = true;
+    std::string error;
+    std::vector<uint8_t> data;
+};
+
+// 每种请求的计数与最近一段时间内的延迟分位数（微秒）。
+struct OpStats {
+    uint64_t count = 0;
+    uint64_t errors = 0;
+    uint64_t p50Us = 0;
+    uint64_t p90Us = 0;
+    uint64_t p99Us = 0;
+    uint64_t maxUs = 0;
+};
+
+struct ServerStats {
+    uint64_t uptimeMs = 0;
+    uint64_t connections = 0;       // 累计接受的连接数
+    uint64_t activeConnections = 0;
+    OpStats ops[3];                 // 依次为 compress / decompress / stats
+    ImageCache::Stats cache;
+};
+
+// 编码函数把完整帧（含长度前缀）写入 frame，复用其已有容量。
+void encodeRequest(const Request &req, std::vector<uint8_t> &frame);
+void encodeResponse(const Response &resp, std::vector<uint8_t> &frame);
+Request decodeRequest(const std::vector<uint8_t> &payload);
+Response decodeResponse(const std::vector<uint8_t> &payload);
+
+void appendImage(const cv::Mat &img, std::vector<uint8_t> &out);
+cv::Mat parseImage(const uint8_t *data, size_t size);
+
+void appendStats(const ServerStats &stats, std::vector<uint8_t> &out);
+ServerStats parseStats(const std::vector<uint8_t> &data);
+
+// 读取一帧负载；对端在帧边界处正常关闭时返回 false，其余错误抛出异常。
+bool readFrame(int fd, std::vector<uint8_t> &payload);
+void writeAll(int fd, const std::vector<uint8_t> &frame);
+}
@@ -0,0 +1,302 @@
+#include "Server.h"
+#include "Protocol.h"
+#include "core/BoundedQueue.h"
+#include "core/Compressor.h"
+#include "core/Decompressor.h"
+#include "core/ImageCache.h"
+#include "core/ImageData.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+void Server::run(const Config &, const std::atomic<bool> &) {
+    throw std::runtime_error("serve mode requires Unix domain sockets, which this platform does not support");
+}
+#else
+namespace {
+const int kPollMs = 200; // 阻塞等待的最长间隔，用于及时响应 stop
+
+// 每种请求保留最近 kWindow 个延迟样本，stats 请求时排序求分位数。
+class LatencyRecorder {
+public:
+    static const size_t kWindow = 8192;
+
+    void record(uint64_t us, bool failed) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (samples.size() < kWindow) {
+            samples.push_back(us);
+        } else {
+            samples[next] = us;
+        }
+        next = (next + 1) % kWindow;
+        count++;
+        if (failed) errors++;
+        maxUs = std::max(maxUs, us);
+    }
+
+    Protocol::OpStats snapshot() const {
+        std::vector<uint64_t> sorted;
+        Protocol::OpStats s;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sorted = samples;
+            s.count = count;
+            s.errors = errors;
+            s.maxUs = maxUs;
+        }
+        if (sorted.empty()) return s;
+        std::sort(sorted.begin(), sorted.end());
+        auto at = [&](double q) { return sorted[static_cast<size_t>(q * (sorted.size() - 1))]; };
+        s.p50Us = at(0.50);
+        s.p90Us = at(0.90);
+        s.p99Us = at(0.99);
+        return s;
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::vector<uint64_t> samples;
+    size_t next = 0;
+    uint64_t count = 0;
+    uint64_t errors = 0;
+    uint64_t maxUs = 0;
+};
+
+struct Shared {
+    explicit Shared(const Server::Config &cfg)
+        : cache(ImageCache::Config{cfg.cacheBytes, 16}), connections(cfg.workers * 4) {}
+    ImageCache cache;
+    BoundedQueue<int> connections;
+    LatencyRecorder latency[3];
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> active{0}; // 已建立且尚未关闭的连接数
+    // 处理完一个请求的连接由工作线程交回，轮询线程再把它放回轮询集合；
+    // 写 wakeFds[1] 唤醒阻塞在 poll 上的轮询线程。
+    std::mutex returnedMutex;
+    std::vector<int> returned;
+    int wakeFds[2] = {-1, -1};
+};
+
+// 工作线程私有的缓冲区，跨请求复用容量，避免每次请求重新分配。
+struct WorkerState {
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> frame;
+    Protocol::Response response;
+};
+
+void handle(Shared &shared, const Protocol::Request &req, Protocol::Response &resp) {
+    resp.data.clear();
+    bool inlineIn = req.flags & Protocol::kInlineInput;
+    bool inlineOut = req.flags & Protocol::kInlineOutput;
+    switch (req.op) {
+        case Protocol::Op::Compress: {
+            cv::Mat img = inlineIn ? Protocol::parseImage(req.data.data(), req.data.size())
+                                   : ImageIO::loadImage(req.inputPath, false);
+            if (inlineOut) {
+                Compressor::compressImage(req.algo, img, resp.data, req.quality);
+            } else {
+                Compressor::compressImage(req.algo, img, req.outputPath, req.quality);
+            }
+            break;
+        }
+        case Protocol::Op::Decompress: {
+            // 按路径解压走缓存：热点文件只在首次或被改写后真正解码。
+            cv::Mat img = inlineIn ? Decompressor::decompressImage(req.algo, req.data.data(), req.data.size())
+                                   : shared.cache.decompress(req.algo, req.inputPath);
+            if (inlineOut) {
+                Protocol::appendImage(img, resp.data);
+            } else {
+                ImageIO::saveImage(req.outputPath, img);
+            }
+            break;
+        }
+        case Protocol::Op::Stats: {
+            Protocol::ServerStats stats;
+            stats.uptimeMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - shared.start).count());
+            stats.connections = shared.accepted;
+            stats.activeConnections = shared.active;
+            for (int i = 0; i < 3; ++i) stats.ops[i] = shared.latency[i].snapshot();
+            stats.cache = shared.cache.stats();
+            Protocol::appendStats(stats, resp.data);
+            break;
+        }
+    }
+}
+
+// 处理连接上的一个请求；客户端已关闭连接时返回 false。
+bool serveRequest(Shared &shared, int fd, WorkerState &ws) {
+    if (!Protocol::readFrame(fd, ws.payload)) return false;
+    auto begin = std::chrono::steady_clock::now();
+    int opIndex = -1;
+    try {
+        Protocol::Request req = Protocol::decodeRequest(ws.payload);
+        opIndex = static_cast<int>(req.op) - 1;
+        ws.response.ok = true;
+        handle(shared, req, ws.response);
+    } catch (const std::exception &ex) {
+        // 请求级错误只返回给客户端，连接保持可用。
+        ws.response.ok = false;
+        ws.response.error = ex.what();
+        ws.response.data.clear();
+    }
+    Protocol::encodeResponse(ws.response, ws.frame);
+    if (opIndex >= 0) {
+        uint64_t us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+        shared.latency[opIndex].record(us, !ws.response.ok);
+    }
+    Protocol::writeAll(fd, ws.frame);
+    return true;
+}
+
+void returnConnection(Shared &shared, int fd) {
+    {
+        std::lock_guard<std::mutex> lock(shared.returnedMutex);
+        shared.returned.push_back(fd);
+    }
+    char byte = 0;
+    ssize_t rc = ::write(shared.wakeFds[1], &byte, 1); // 管道已满时轮询线程必然会被唤醒，忽略 EAGAIN
+    (void)rc;
+}
+
+void closeConnection(Shared &shared, int fd) {
+    shared.active--;
+    ::close(fd);
+}
+
+int listenOn(const std::string &path) {
+    sockaddr_un addr{};
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Invalid socket path: " + path);
+    }
+    // 只清理上次异常退出残留的 socket 文件，路径被普通文件等占用时报错而不是删除它。
+    struct stat st;
+    if (::lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) throw std::runtime_error("Cannot listen on " + path + ": path exists and is not a socket");
+        ::unlink(path.c_str());
+    } else if (errno != ENOENT) {
+        throw std::runtime_error("Cannot listen on " + path + ": " + std::strerror(errno));
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error(std::string("socket() failed: ") + std::strerror(errno));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 64) < 0) {
+        std::string err = std::strerror(errno);
+        ::close(fd);
+        throw std::runtime_error("Cannot listen on " + path + ": " + err);
+    }
+    return fd;
+}
+}
+
+void Server::run(const Config &config, const std::atomic<bool> &stop) {
+    Config cfg = config;
+    if (cfg.workers == 0) cfg.workers = std::max(1u, std::thread::hardware_concurrency());
+    int listenFd = listenOn(cfg.socketPath);
+    Shared shared(cfg);
+    if (::pipe(shared.wakeFds) < 0) {
+        std::string err = std::strerror(errno);
+        ::close(listenFd);
+        throw std::runtime_error("pipe() failed: " + err);
+    }
+    for (int wakeFd : shared.wakeFds) ::fcntl(wakeFd, F_SETFL, ::fcntl(wakeFd, F_GETFL) | O_NONBLOCK);
+
+    // 工作线程每次只处理一个请求，随后把连接交回轮询集合，
+    // 空闲的长连接不会占住线程，使其他连接饿死。
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < cfg.workers; ++i) {
+        workers.emplace_back([&] {
+            WorkerState ws;
+            int fd;
+            while (shared.connections.pop(fd)) {
+                bool keep = false;
+                try {
+                    keep = serveRequest(shared, fd, ws);
+                } catch (const std::exception &ex) {
+                    std::cerr << "Connection error: " << ex.what() << "\n";
+                }
+                if (keep) {
+                    returnConnection(shared, fd);
+                } else {
+                    closeConnection(shared, fd);
+                }
+            }
+        });
+    }
+
+    std::cout << "Listening on " << cfg.socketPath << " with " << cfg.workers << " workers\n";
+    // pfds 依次为监听 socket、唤醒管道读端和 idle 中的各连接。
+    std::vector<int> idle;
+    std::vector<pollfd> pfds;
+    while (!stop) {
+        {
+            std::lock_guard<std::mutex> lock(shared.returnedMutex);
+            idle.insert(idle.end(), shared.returned.begin(), shared.returned.end());
+            shared.returned.clear();
+        }
+        pfds.clear();
+        pfds.push_back({listenFd, POLLIN, 0});
+        pfds.push_back({shared.wakeFds[0], POLLIN, 0});
+        for (int fd : idle) pfds.push_back({fd, POLLIN, 0});
+        int rc = ::poll(pfds.data(), pfds.size(), kPollMs);
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "poll() failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+        if (rc == 0) continue;
+        if (pfds[1].revents) {
+            char drain[64];
+            while (::read(shared.wakeFds[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+        // 有数据或已挂断的连接交给工作线程，挂断的由其读到 EOF 后关闭。
+        size_t kept = 0;
+        for (size_t i = 0; i < idle.size(); ++i) {
+            if (pfds[i + 2].revents) {
+                shared.connections.push(idle[i]);
+            } else {
+                idle[kept++] = idle[i];
+            }
+        }
+        idle.resize(kept);
+        if (pfds[0].revents) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                std::cerr << "accept() failed: " << std::strerror(errno) << "\n";
+                break;
+            }
+            shared.accepted++;
+            shared.active++;
+            shared.connections.push(fd);
+        }
+    }
+
+    shared.connections.close();
+    for (auto &t : workers) t.join();
+    idle.insert(idle.end(), shared.returned.begin(), shared.returned.end());
+    for (int fd : idle) closeConnection(shared, fd);
+    for (int wakeFd : shared.wakeFds) ::close(wakeFd);
+    ::close(listenFd);
+    ::unlink(cfg.socketPath.c_str());
+}
+#endif
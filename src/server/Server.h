@@ -0,0 +1,18 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+// Resident compression daemon: keeps codec tables, the decoded-image cache and
+// worker threads warm between requests instead of paying process startup per file.
+// 仅支持 POSIX 平台（Unix domain socket），其他平台调用时抛出异常。
+namespace Server {
+struct Config {
+    std::string socketPath;
+    size_t workers = 0;                         // 0 表示使用硬件并发数；每个线程一次处理一个请求
+    size_t cacheBytes = 256u * 1024 * 1024;     // 按路径解压时使用的 ImageCache 预算
+};
+
+// 阻塞运行，直到 stop 被置位（通常由信号处理函数设置）；退出时删除 socket 文件。
+void run(const Config &config, const std::atomic<bool> &stop);
+}